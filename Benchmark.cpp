@@ -0,0 +1,1839 @@
+#include "Benchmark.h"
+#include "ObjectLoader.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "Mesh.h"
+#include "SceneBvh.h"
+#include "TransformStore.h"
+#include "JobSystem.h"
+#include "SimulationThread.h"
+#include "StreamRing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    static double SecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    static bool SameMesh(const CpuMeshData& a, const CpuMeshData& b)
+    {
+        if (a.vertices != b.vertices || a.indices != b.indices) return false;
+        if (a.materials.size() != b.materials.size() || a.submeshes.size() != b.submeshes.size()) return false;
+
+        for (size_t i = 0; i < a.materials.size(); i++)
+            if (a.materials[i].name != b.materials[i].name) return false;
+
+        for (size_t i = 0; i < a.submeshes.size(); i++)
+        {
+            const SubMesh& x = a.submeshes[i];
+            const SubMesh& y = b.submeshes[i];
+            if (x.material != y.material || x.indexOffset != y.indexOffset || x.indexCount != y.indexCount) return false;
+        }
+        return true;
+    }
+
+    // Writes `copies` back-to-back copies of an OBJ, offsetting absolute face indices
+    // so every copy references its own v/vt/vn block. Returns the written size in bytes.
+    static size_t WriteScaledObj(const std::string& src, const std::string& dst, int copies)
+    {
+        std::ifstream in(src);
+        if (!in.is_open()) return 0;
+
+        std::vector<std::string> lines;
+        int nv = 0, nvt = 0, nvn = 0;
+        for (std::string line; std::getline(in, line); )
+        {
+            if (line.rfind("v ", 0) == 0) nv++;
+            else if (line.rfind("vt ", 0) == 0) nvt++;
+            else if (line.rfind("vn ", 0) == 0) nvn++;
+            lines.push_back(line);
+        }
+
+        std::ofstream out(dst, std::ios::binary);
+        for (int c = 0; c < copies; c++)
+        {
+            const int offs[3] = { c * nv, c * nvt, c * nvn };
+
+            for (const auto& line : lines)
+            {
+                if (line.rfind("f ", 0) != 0)
+                {
+                    out << line << '\n';
+                    continue;
+                }
+
+                std::stringstream ss(line.substr(2));
+                out << 'f';
+                for (std::string tok; ss >> tok; )
+                {
+                    out << ' ';
+                    int slot = 0;
+                    size_t pos = 0;
+                    while (pos <= tok.size())
+                    {
+                        const size_t slash = std::min(tok.find('/', pos), tok.size());
+                        const std::string part = tok.substr(pos, slash - pos);
+                        if (!part.empty())
+                        {
+                            const int idx = std::atoi(part.c_str());
+                            out << (idx > 0 ? idx + offs[slot] : idx);
+                        }
+                        if (slash < tok.size()) out << '/';
+                        pos = slash + 1;
+                        slot = std::min(slot + 1, 2);
+                    }
+                }
+                out << '\n';
+            }
+        }
+
+        return (size_t)out.tellp();
+    }
+
+    // Mapped loader vs. stream loader on a scaled-up OBJ
+    static int ObjLoad(int argc, char** argv)
+    {
+        const std::string src = argc > 0 ? argv[0] : "Models/Testing1.obj";
+        const int copies = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+        const int runs = argc > 2 ? std::max(1, std::atoi(argv[2])) : 3;
+        const std::string scaled = "bench_scaled.obj";
+
+        const size_t bytes = WriteScaledObj(src, scaled, copies);
+        if (bytes == 0)
+        {
+            std::cout << "bench obj: cannot read " << src << "\n";
+            return 1;
+        }
+
+        const double mb = double(bytes) / (1024.0 * 1024.0);
+        std::cout << "bench obj: " << src << " x" << copies << " = " << mb << " MB\n";
+
+        double bestStream = 1e30, bestMapped = 1e30;
+        CpuMeshData ref, fast;
+
+        // Parser throughput only (LoadOBJ does not optimize); vertexcache measures the optimizer
+        ObjectLoader::SetDedupStats(true);
+
+        for (int r = 0; r < runs; r++)
+        {
+            auto t0 = Clock::now();
+            ref = ObjectLoader::LoadOBJStream(scaled);
+            bestStream = std::min(bestStream, SecondsSince(t0));
+
+            t0 = Clock::now();
+            fast = ObjectLoader::LoadOBJ(scaled, 1);
+            bestMapped = std::min(bestMapped, SecondsSince(t0));
+        }
+
+        ObjectLoader::SetDedupStats(false);
+        std::remove(scaled.c_str());
+
+        std::cout << "stream: " << bestStream * 1000.0 << " ms, " << mb / bestStream << " MB/s\n";
+        std::cout << "mapped: " << bestMapped * 1000.0 << " ms, " << mb / bestMapped << " MB/s\n";
+        std::cout << "speedup: " << bestStream / bestMapped << "x\n";
+        std::cout << "identical output: " << (SameMesh(ref, fast) ? "yes" : "NO") << "\n";
+
+        return SameMesh(ref, fast) ? 0 : 1;
+    }
+
+    // Chunked loader scaling from 1 thread up to maxThreads (doubling)
+    static int ObjLoadThreads(int argc, char** argv)
+    {
+        const std::string src = argc > 0 ? argv[0] : "Models/Testing1.obj";
+        const int copies = argc > 1 ? std::max(1, std::atoi(argv[1])) : 400;
+        const unsigned int hw = std::max(1u, std::thread::hardware_concurrency());
+        const unsigned int maxThreads = argc > 2 ? (unsigned int)std::max(1, std::atoi(argv[2])) : hw;
+        const std::string scaled = "bench_scaled.obj";
+
+        const size_t bytes = WriteScaledObj(src, scaled, copies);
+        if (bytes == 0)
+        {
+            std::cout << "bench objmt: cannot read " << src << "\n";
+            return 1;
+        }
+
+        const double mb = double(bytes) / (1024.0 * 1024.0);
+        std::cout << "bench objmt: " << src << " x" << copies << " = " << mb << " MB\n";
+
+        CpuMeshData ref;
+        double serial = 0.0;
+        bool allSame = true;
+
+        std::vector<unsigned int> counts;
+        for (unsigned int t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+        counts.push_back(maxThreads);
+
+        std::vector<std::string> rows;
+        for (unsigned int t : counts)
+        {
+            auto t0 = Clock::now();
+            CpuMeshData m = ObjectLoader::LoadOBJ(scaled, t);
+            const double sec = SecondsSince(t0);
+
+            if (t == 1) { ref = std::move(m); serial = sec; }
+            else allSame = allSame && SameMesh(ref, m);
+
+            std::ostringstream row;
+            row << "threads " << t << ": " << sec * 1000.0 << " ms, " << mb / sec << " MB/s, "
+                << serial / sec << "x";
+            rows.push_back(row.str());
+        }
+
+        std::remove(scaled.c_str());
+
+        for (const auto& r : rows) std::cout << r << "\n";
+        std::cout << "identical output: " << (allSame ? "yes" : "NO") << "\n";
+        return allSame ? 0 : 1;
+    }
+
+    // Cold import (parse, LODs, meshlets, cache write) vs. mapped cache hit vs. plain memcpy of the same payload
+    static int MeshCacheLoad(int argc, char** argv)
+    {
+        const std::string src = argc > 0 ? argv[0] : "Models/Testing1.obj";
+        const int copies = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+        const int runs = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+        const std::string scaled = "bench_scaled.obj";
+
+        if (WriteScaledObj(src, scaled, copies) == 0)
+        {
+            std::cout << "bench meshcache: cannot read " << src << "\n";
+            return 1;
+        }
+
+        auto t0 = Clock::now();
+        const CpuMeshData parsed = ObjectLoader::ImportOBJ(scaled);
+        const double parseSec = SecondsSince(t0);
+
+        const size_t payload = parsed.vertices.size() * sizeof(float) + parsed.indices.size() * sizeof(GLuint);
+        const double mb = double(payload) / (1024.0 * 1024.0);
+
+        // Stand-in for the glBufferData copy a real upload does
+        std::vector<char> staging(payload);
+
+        double bestHit = 1e30, bestCopy = 1e30;
+        bool hitOk = true;
+        for (int r = 0; r < runs; r++)
+        {
+            t0 = Clock::now();
+            MeshCache cache;
+            hitOk = hitOk && cache.Open(scaled);
+            if (hitOk)
+            {
+                std::memcpy(staging.data(), cache.Vertices(), cache.VertexFloatCount() * sizeof(float));
+                std::memcpy(staging.data() + cache.VertexFloatCount() * sizeof(float), cache.Indices(),
+                    cache.IndexCount() * sizeof(GLuint));
+            }
+            bestHit = std::min(bestHit, SecondsSince(t0));
+
+            t0 = Clock::now();
+            std::memcpy(staging.data(), parsed.vertices.data(), parsed.vertices.size() * sizeof(float));
+            std::memcpy(staging.data() + parsed.vertices.size() * sizeof(float), parsed.indices.data(),
+                parsed.indices.size() * sizeof(GLuint));
+            bestCopy = std::min(bestCopy, SecondsSince(t0));
+        }
+
+        bool same = false;
+        {
+            MeshCache cache;
+            same = cache.Open(scaled)
+                && std::memcmp(cache.Vertices(), parsed.vertices.data(), parsed.vertices.size() * sizeof(float)) == 0
+                && std::memcmp(cache.Indices(), parsed.indices.data(), parsed.indices.size() * sizeof(GLuint)) == 0;
+        }
+
+        std::remove(MeshCache::CachePathFor(scaled).c_str());
+        std::remove(scaled.c_str());
+
+        std::cout << "bench meshcache: payload " << mb << " MB\n";
+        std::cout << "import + write: " << parseSec * 1000.0 << " ms\n";
+        std::cout << "cache hit:     " << bestHit * 1000.0 << " ms, " << mb / bestHit << " MB/s\n";
+        std::cout << "memcpy:        " << bestCopy * 1000.0 << " ms, " << mb / bestCopy << " MB/s\n";
+        std::cout << "cache valid: " << (hitOk && same ? "yes" : "NO") << "\n";
+        return hitOk && same ? 0 : 1;
+    }
+
+    // Hidden window + GL context for the render benchmarks; vsync off so frames are not capped
+    static GLFWwindow* InitHiddenWindow(int w, int h)
+    {
+        glfwInit();
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+        // 4.3 for the indirect draw path, else the 3.3 baseline
+        GLFWwindow* window = nullptr;
+        static const int kVersions[][2] = { { 4, 3 }, { 3, 3 } };
+        for (const auto& v : kVersions)
+        {
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, v[0]);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, v[1]);
+            window = glfwCreateWindow(w, h, "bench", NULL, NULL);
+            if (window) break;
+        }
+
+        if (!window)
+        {
+            glfwTerminate();
+            return nullptr;
+        }
+
+        glfwMakeContextCurrent(window);
+        gladLoadGL();
+        glfwSwapInterval(0);
+        glViewport(0, 0, w, h);
+        glEnable(GL_DEPTH_TEST);
+        return window;
+    }
+
+    // `count` cubes/circles on a grid in front of the camera, cycling textures and motions
+    static void SpawnGridScene(MeshSystem& mesh, int count)
+    {
+        static const char* kMeshes[] = { "cube", "circle" };
+        static const char* kTextures[] = { "brick", "metal", "anime" };
+        static const Motion kMotions[] = { Motion::None, Motion::RotateX, Motion::RotateY, Motion::RotateXY, Motion::BobY };
+
+        const int side = (int)std::ceil(std::sqrt((double)count));
+        for (int i = 0; i < count; i++)
+        {
+            const float x = float(i % side) - 0.5f * float(side);
+            const float z = -2.0f - float(i / side);
+
+            SceneObjectDesc o;
+            o.name = "Obj" + std::to_string(i);
+            o.meshId = kMeshes[i % 2];
+            o.textureId = kTextures[(i / 2) % 3];
+            o.shaderId = "default";
+            o.pos = { x, float(i % 3) - 1.0f, z };
+            o.scale = glm::vec3(0.4f);
+            o.motion = kMotions[i % 5];
+            o.rotSpeedDeg = 45.0f;
+            o.bobAmp = 0.25f;
+            o.bobFreq = 2.0f;
+            mesh.AddObjectInstance(o);
+        }
+    }
+
+    struct FrameTiming
+    {
+        double cpuMs = 0.0;     // Render() only: CPU-side submission
+        double frameMs = 0.0;   // Render() + glFinish
+    };
+
+    static FrameTiming TimeFrames(MeshSystem& mesh, Camera& camera, int frames)
+    {
+        for (int i = 0; i < 3; i++) mesh.Render(camera, 0.0f);
+        glFinish();
+
+        FrameTiming ft;
+        for (int i = 0; i < frames; i++)
+        {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            const auto t0 = Clock::now();
+            mesh.Render(camera, float(i) / 60.0f);
+            ft.cpuMs += SecondsSince(t0) * 1000.0;
+
+            glFinish();
+            ft.frameMs += SecondsSince(t0) * 1000.0;
+        }
+
+        ft.cpuMs /= frames;
+        ft.frameMs /= frames;
+        return ft;
+    }
+
+    // Per-object draws vs. instanced batches vs. instancing without culling, with model matrices
+    // from the CPU and animated in the vertex shader, same scene
+    static int RenderInstancing(int argc, char** argv)
+    {
+        const int count = argc > 0 ? std::max(1, std::atoi(argv[0])) : 10000;
+        const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100;
+
+        GLFWwindow* window = InitHiddenWindow(800, 800);
+        if (!window) return 1;
+
+        int rc = 0;
+        {
+            Shader shader("Default.vert", "Default.frag");
+            Camera camera(800, 800, glm::vec3(0, 0, 2));
+
+            MeshSystem mesh;
+            mesh.AddPrimitiveMesh("cube", gfx::ShapeType::Cube);
+            mesh.AddPrimitiveMesh("circle", gfx::ShapeType::Circle);
+            mesh.AddTexture("brick", "brick.jpg");
+            mesh.AddTexture("metal", "metal.jpg");
+            mesh.AddTexture("anime", "poza.jpg");
+            mesh.RegisterShaderProgram("default", shader);
+            SpawnGridScene(mesh, count);
+
+            std::cout << "bench render: " << count << " objects, " << frames << " frames\n";
+
+            struct Mode { const char* label; bool instanced; bool culled; bool gpuMotion; };
+            static const Mode kModes[] = {
+                { "per-object: ", false, true, false },
+                { "instanced:  ", true, true, false },
+                { "no culling: ", true, false, false },
+                { "gpu motion: ", true, true, true },
+                { "gpu, all:   ", true, false, true },
+            };
+
+            for (const Mode& mode : kModes)
+            {
+                mesh.SetInstancing(mode.instanced);
+                mesh.SetFrustumCulling(mode.culled);
+                mesh.SetGpuMotion(mode.gpuMotion);
+                const FrameTiming ft = TimeFrames(mesh, camera, frames);
+                const RenderStats& s = mesh.GetStats();
+
+                std::cout << mode.label
+                    << s.drawCalls << " draw calls, " << s.batches << " batches, "
+                    << ft.cpuMs << " ms cpu, " << ft.frameMs << " ms frame\n"
+                    << "            " << s.visible << " visible, " << s.culled << " culled; binds: "
+                    << s.shaderBinds << " shader, " << s.textureBinds << " texture, "
+                    << s.vaoBinds << " vao, " << s.bindsAvoided << " avoided; "
+                    << s.uploadBytes / 1024 << " KB uploaded\n";
+            }
+
+            mesh.Shutdown();
+            shader.Delete();
+        }
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return rc;
+    }
+
+    static std::vector<unsigned char> ReadFramebuffer(int w, int h)
+    {
+        std::vector<unsigned char> pixels((size_t)w * h * 3);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+        return pixels;
+    }
+
+    // CPU time of Submit alone for the same prepared frames, drawn by the DrawBatch loop and by
+    // multi-draw indirect, per object and instanced, culled and not. Every mode must draw the same image.
+    static int IndirectSubmission(int argc, char** argv)
+    {
+        const int count = argc > 0 ? std::max(1, std::atoi(argv[0])) : 20000;
+        const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 50;
+        const int warmup = 3;
+
+        GLFWwindow* window = InitHiddenWindow(800, 800);
+        if (!window) return 1;
+
+        bool allSame = true;
+        {
+            Shader shader("Default.vert", "Default.frag");
+            Camera camera(800, 800, glm::vec3(0, 0, 2));
+
+            MeshSystem mesh;
+            mesh.AddPrimitiveMesh("cube", gfx::ShapeType::Cube);
+            mesh.AddPrimitiveMesh("circle", gfx::ShapeType::Circle);
+            mesh.AddTexture("brick", "brick.jpg");
+            mesh.AddTexture("metal", "metal.jpg");
+            mesh.AddTexture("anime", "poza.jpg");
+            mesh.RegisterShaderProgram("default", shader);
+            SpawnGridScene(mesh, count);
+
+            if (!mesh.SetIndirectDraw(true))
+                allSame = false;
+
+            std::cout << "bench indirect: " << count << " objects, " << frames << " frames\n";
+
+            struct Mode { const char* label; bool instanced; bool indirect; };
+            static const Mode kModes[] = {
+                { "  loop, per object:     ", false, false },
+                { "  indirect, per object: ", false, true },
+                { "  loop, instanced:      ", true, false },
+                { "  indirect, instanced:  ", true, true },
+            };
+
+            for (int culled = 1; culled >= 0 && allSame; culled--)
+            {
+                mesh.SetFrustumCulling(culled != 0);
+                std::cout << (culled ? "culled:\n" : "no culling:\n");
+
+                std::vector<unsigned char> reference;
+                RenderSnapshot frame;
+
+                for (const Mode& mode : kModes)
+                {
+                    mesh.SetInstancing(mode.instanced);
+                    mesh.SetIndirectDraw(mode.indirect);
+
+                    double submitMs = 0.0, frameMs = 0.0;
+                    for (int i = -warmup; i < frames; i++)
+                    {
+                        mesh.Prepare(frame, camera, float(std::max(i, 0)) / 60.0f);
+                        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                        const auto t0 = Clock::now();
+                        mesh.Submit(frame);
+                        const double submit = SecondsSince(t0) * 1000.0;
+                        glFinish();
+                        const double total = SecondsSince(t0) * 1000.0;
+
+                        if (i >= 0) { submitMs += submit; frameMs += total; }
+                    }
+
+                    const std::vector<unsigned char> pixels = ReadFramebuffer(800, 800);
+                    const bool same = reference.empty() || pixels == reference;
+                    if (reference.empty()) reference = pixels;
+                    allSame = allSame && same;
+
+                    const RenderStats& s = mesh.GetStats();
+                    std::cout << mode.label << s.drawCalls << " draw calls, " << s.indirectDraws << " commands, "
+                        << submitMs / frames << " ms submit, " << frameMs / frames << " ms frame"
+                        << (same ? "" : ", IMAGE DIFFERS") << "\n";
+                }
+            }
+
+            std::cout << "same image: " << (allSame ? "yes" : "NO") << "\n";
+
+            mesh.Shutdown();
+            shader.Delete();
+        }
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return allSame ? 0 : 1;
+    }
+
+    // CPU culling (BVH and flat SIMD) vs. the compute shader stage, all animated by GPU motion so
+    // only the culling differs. The GPU runs the flat pass's test, so its visible count (debug readback)
+    // must match that one; every image must match. The BVH may keep a few more objects.
+    static int GpuCulling(int argc, char** argv)
+    {
+        const int count = argc > 0 ? std::max(1, std::atoi(argv[0])) : 100000;
+        const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+
+        GLFWwindow* window = InitHiddenWindow(800, 800);
+        if (!window) return 1;
+
+        bool ok = true;
+        {
+            Shader shader("Default.vert", "Default.frag");
+            Camera camera(800, 800, glm::vec3(0, 0, 2));
+
+            MeshSystem mesh;
+            mesh.AddPrimitiveMesh("cube", gfx::ShapeType::Cube);
+            mesh.AddPrimitiveMesh("circle", gfx::ShapeType::Circle);
+            mesh.AddTexture("brick", "brick.jpg");
+            mesh.AddTexture("metal", "metal.jpg");
+            mesh.AddTexture("anime", "poza.jpg");
+            mesh.RegisterShaderProgram("default", shader);
+            SpawnGridScene(mesh, count);
+            mesh.SetGpuMotion(true);
+
+            std::cout << "bench gpucull: " << count << " objects, " << frames << " frames\n";
+
+            struct Mode { const char* label; bool gpu; bool bvh; bool readback; };
+            static const Mode kModes[] = {
+                { "cpu, flat:     ", false, false, false },
+                { "cpu, bvh:      ", false, true, false },
+                { "gpu:           ", true, false, false },
+                { "gpu, readback: ", true, false, true },
+            };
+
+            std::vector<unsigned char> reference;
+            unsigned int cpuVisible = 0;
+
+            for (const Mode& mode : kModes)
+            {
+                mesh.SetBvhCulling(mode.bvh);
+                mesh.SetGpuCullingReadback(mode.readback);
+                if (!mesh.SetGpuCulling(mode.gpu))
+                {
+                    ok = false;
+                    break;
+                }
+
+                const FrameTiming ft = TimeFrames(mesh, camera, frames);
+                const RenderStats& s = mesh.GetStats();
+
+                const std::vector<unsigned char> pixels = ReadFramebuffer(800, 800);
+                const bool same = reference.empty() || pixels == reference;
+                if (reference.empty()) { reference = pixels; cpuVisible = s.visible; }
+                ok = ok && same && (!mode.readback || s.visible == cpuVisible);
+
+                std::cout << mode.label << ft.cpuMs << " ms cpu, " << ft.frameMs << " ms frame, "
+                    << s.drawCalls << " draw calls, " << s.indirectDraws << " commands; ";
+                if (mode.gpu && !mode.readback) std::cout << "visible not read back";
+                else std::cout << s.visible << " visible";
+                std::cout << (same ? "" : ", IMAGE DIFFERS") << "\n";
+            }
+
+            std::cout << "matches cpu culling: " << (ok ? "yes" : "NO") << "\n";
+
+            mesh.Shutdown();
+            shader.Delete();
+        }
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return ok ? 0 : 1;
+    }
+
+    // Per-frame upload of `objects` model matrices and a uniform block, each frame read back on the
+    // GPU by a buffer copy: orphaning with glBufferData, glBufferSubData into one buffer (the driver
+    // must sync or copy), and StreamRing mapping each write unsynchronized or persistently mapped.
+    // Frames are only flushed, not finished, so any sync the driver inserts shows in the time.
+    static int StreamUploads(int argc, char** argv)
+    {
+        const int count = argc > 0 ? std::max(1, std::atoi(argv[0])) : 20000;
+        const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+        const int warmup = 10;
+
+        GLFWwindow* window = InitHiddenWindow(64, 64);
+        if (!window) return 1;
+
+        bool allOk = true;
+        {
+            std::vector<glm::mat4> matrices((size_t)count, glm::mat4(1.0f));
+            const FrameUniforms uniforms;
+            const size_t bytes = matrices.size() * sizeof(glm::mat4);
+
+            GLint uboAlign = 256;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uboAlign);
+
+            GLuint sink = 0;
+            glGenBuffers(1, &sink);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, sink);
+            glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)bytes, nullptr, GL_STATIC_COPY);
+
+            std::cout << "bench stream: " << count << " matrices (" << bytes / 1024 << " KB) per frame, "
+                << frames << " frames\n";
+
+            enum class Upload { Orphan, SubData, RingMapped, RingPersistent };
+            struct Mode { const char* label; Upload upload; };
+            static const Mode kModes[] = {
+                { "glBufferData orphan:    ", Upload::Orphan },
+                { "glBufferSubData:        ", Upload::SubData },
+                { "ring, map per write:    ", Upload::RingMapped },
+                { "ring, persistent map:   ", Upload::RingPersistent },
+            };
+
+            for (const Mode& mode : kModes)
+            {
+                if (mode.upload == Upload::RingPersistent && !GetGlExtensions().bufferStorage)
+                {
+                    std::cout << mode.label << "needs GL 4.4 or ARB_buffer_storage\n";
+                    continue;
+                }
+
+                StreamRing ring(mode.upload == Upload::RingPersistent);
+                GLuint buffer = 0;
+                glGenBuffers(1, &buffer);
+                glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+                glBufferData(GL_COPY_READ_BUFFER, (GLsizeiptr)(bytes + sizeof(FrameUniforms)), nullptr, GL_STREAM_DRAW);
+
+                Clock::time_point t0;
+                for (int i = -warmup; i < frames; i++)
+                {
+                    if (i == 0) { glFinish(); t0 = Clock::now(); }
+
+                    // Tag the frame so the last copy can be checked
+                    matrices[0][0][0] = float(i);
+                    GLuint source = buffer;
+                    size_t offset = 0;
+
+                    if (mode.upload == Upload::Orphan)
+                    {
+                        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+                        glBufferData(GL_COPY_READ_BUFFER, (GLsizeiptr)(bytes + sizeof(FrameUniforms)), nullptr, GL_STREAM_DRAW);
+                        glBufferSubData(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)bytes, matrices.data());
+                        glBufferSubData(GL_COPY_READ_BUFFER, (GLintptr)bytes, sizeof(FrameUniforms), &uniforms);
+                    }
+                    else if (mode.upload == Upload::SubData)
+                    {
+                        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+                        glBufferSubData(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)bytes, matrices.data());
+                        glBufferSubData(GL_COPY_READ_BUFFER, (GLintptr)bytes, sizeof(FrameUniforms), &uniforms);
+                    }
+                    else
+                    {
+                        ring.BeginFrame(bytes + 16 + sizeof(FrameUniforms) + (size_t)uboAlign);
+                        offset = ring.Write(matrices.data(), bytes, 16);
+                        ring.Write(&uniforms, sizeof(FrameUniforms), (size_t)uboAlign);
+                        source = ring.Buffer();
+                    }
+
+                    glBindBuffer(GL_COPY_READ_BUFFER, source);
+                    glBindBuffer(GL_COPY_WRITE_BUFFER, sink);
+                    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)offset, 0, (GLsizeiptr)bytes);
+
+                    if (mode.upload >= Upload::RingMapped) ring.EndFrame();
+                    glFlush();
+                }
+                glFinish();
+                const double ms = SecondsSince(t0) * 1000.0 / frames;
+
+                float tag = -1.0f;
+                glBindBuffer(GL_COPY_WRITE_BUFFER, sink);
+                glGetBufferSubData(GL_COPY_WRITE_BUFFER, 0, sizeof(float), &tag);
+                const bool ok = tag == float(frames - 1);
+                allOk = allOk && ok;
+
+                std::cout << mode.label << ms << " ms/frame, " << double(bytes) / (ms / 1000.0) / (1024.0 * 1024.0)
+                    << " MB/s" << (ok ? "" : ", WRONG DATA") << "\n";
+
+                ring.Delete();
+                glDeleteBuffers(1, &buffer);
+            }
+
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            glDeleteBuffers(1, &sink);
+        }
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return allOk ? 0 : 1;
+    }
+
+    // Full 44-byte vertices vs. VertexLayout::Compact for the grid primitives and an OBJ model:
+    // GPU bytes per mesh, vertex bytes fetched per frame and frame time with every object drawn,
+    // and how far the quantized image strays from the full one
+    static int VertexFormats(int argc, char** argv)
+    {
+        const int count = argc > 0 ? std::max(1, std::atoi(argv[0])) : 20000;
+        const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 50;
+        const std::string model = argc > 2 ? argv[2] : "Models/Testing1.obj";
+
+        GLFWwindow* window = InitHiddenWindow(800, 800);
+        if (!window) return 1;
+
+        CpuMeshData modelData = ObjectLoader::LoadOBJ(model);
+        MeshOptimizer::Optimize(modelData);    // as ImportOBJ leaves it
+        std::cout << "bench vertexformat: " << count << " objects, " << frames << " frames, model " << model
+            << (modelData.vertices.empty() ? " (not found)" : "") << "\n";
+
+        {
+            Shader shader("Default.vert", "Default.frag");
+            Camera camera(800, 800, glm::vec3(0, 0, 2));
+
+            struct Mode { const char* label; VertexLayout layout; };
+            const Mode kModes[] = {
+                { "full:    ", VertexLayout::Full() },
+                { "compact: ", VertexLayout::Compact() },
+            };
+
+            std::vector<unsigned char> reference;
+            for (const Mode& mode : kModes)
+            {
+                MeshSystem mesh;
+                mesh.SetVertexLayout(mode.layout);
+                mesh.AddPrimitiveMesh("cube", gfx::ShapeType::Cube);
+                mesh.AddPrimitiveMesh("circle", gfx::ShapeType::Circle);
+                if (!modelData.vertices.empty()) mesh.AddMesh("model", modelData);
+                mesh.AddTexture("brick", "brick.jpg");
+                mesh.AddTexture("metal", "metal.jpg");
+                mesh.AddTexture("anime", "poza.jpg");
+                mesh.RegisterShaderProgram("default", shader);
+                SpawnGridScene(mesh, count);
+                if (!modelData.vertices.empty())
+                    mesh.AddObjectInstance({ "Model", "model", "brick", "default", { 0.0f, 0.0f, -1.0f }, glm::vec3(0.5f), Motion::RotateY, 30.0f });
+                mesh.SetFrustumCulling(false);
+
+                // SpawnGridScene alternates cube, circle
+                const size_t cubes = (size_t(count) + 1) / 2, circles = size_t(count) / 2;
+                size_t bytes = 0, fullBytes = 0, fetch = 0, fullFetch = 0;
+
+                std::cout << mode.label << "\n";
+                for (const MeshMemoryStats& m : mesh.GetMeshMemory())
+                {
+                    const size_t instances = m.id == "cube" ? cubes : m.id == "circle" ? circles : 1;
+                    bytes += m.bytes;
+                    fullBytes += m.fullBytes;
+                    fetch += instances * m.vertices * m.vertexStride;
+                    fullFetch += instances * m.vertices * VertexLayout::Full().Stride();
+
+                    std::cout << "  " << m.id << ": " << m.vertices << " vertices x " << m.vertexStride << " B + "
+                        << m.indices << " indices = " << m.bytes / 1024.0 << " KB ("
+                        << 100.0 * double(m.bytes) / double(m.fullBytes) << "% of full)\n";
+                }
+
+                const FrameTiming ft = TimeFrames(mesh, camera, frames);
+                const std::vector<unsigned char> pixels = ReadFramebuffer(800, 800);
+                if (reference.empty()) reference = pixels;
+
+                // Edge pixels of intersecting triangles flip outright, so the mean says more than the max
+                size_t differing = 0, diffSum = 0;
+                for (size_t i = 0; i < pixels.size(); i += 3)
+                {
+                    int d = 0;
+                    for (size_t c = 0; c < 3; c++)
+                        d = std::max(d, std::abs(int(pixels[i + c]) - int(reference[i + c])));
+                    if (d > 0) differing++;
+                    diffSum += (size_t)d;
+                }
+
+                std::cout << "  total " << bytes / 1024.0 << " KB (" << 100.0 * double(bytes) / double(fullBytes)
+                    << "% of full); vertex fetch " << fetch / (1024.0 * 1024.0) << " MB/frame ("
+                    << 100.0 * double(fetch) / double(fullFetch) << "%)\n"
+                    << "  " << ft.cpuMs << " ms cpu, " << ft.frameMs << " ms frame; " << differing
+                    << " pixels differ from full, mean difference " << double(diffSum) / double(pixels.size() / 3) << "/255\n";
+
+                mesh.Shutdown();
+            }
+
+            shader.Delete();
+        }
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 0;
+    }
+
+    // The grid drawn by the position-only Object shader from the interleaved vertices and from a
+    // position stream, for the full and the compact layout. Each stream pair must draw the same image.
+    static int PositionStreams(int argc, char** argv)
+    {
+        const int count = argc > 0 ? std::max(1, std::atoi(argv[0])) : 20000;
+        const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 50;
+
+        GLFWwindow* window = InitHiddenWindow(800, 800);
+        if (!window) return 1;
+
+        bool allSame = true;
+        {
+            Shader shader("Object.vert", "Object.frag");
+            Camera camera(800, 800, glm::vec3(0, 0, 2));
+
+            std::cout << "bench positions: " << count << " objects, " << frames << " frames, unculled\n";
+
+            struct Mode { const char* label; VertexLayout layout; bool positionStream; };
+            const Mode kModes[] = {
+                { "full, interleaved:        ", VertexLayout::Full(), false },
+                { "full, position stream:    ", VertexLayout::Full(), true },
+                { "compact, interleaved:     ", VertexLayout::Compact(), false },
+                { "compact, position stream: ", VertexLayout::Compact(), true },
+            };
+
+            std::vector<unsigned char> reference;
+            for (const Mode& mode : kModes)
+            {
+                VertexLayout layout = mode.layout;
+                layout.positionStream = mode.positionStream;
+
+                MeshSystem mesh;
+                mesh.SetVertexLayout(layout);
+                mesh.AddPrimitiveMesh("cube", gfx::ShapeType::Cube);
+                mesh.AddPrimitiveMesh("circle", gfx::ShapeType::Circle);
+                mesh.RegisterShaderProgram("default", shader);   // the id SpawnGridScene uses
+                SpawnGridScene(mesh, count);
+                mesh.SetFrustumCulling(false);
+
+                // SpawnGridScene alternates cube, circle; the shader fetches one of the two streams
+                size_t fetch = 0;
+                for (const MeshMemoryStats& m : mesh.GetMeshMemory())
+                {
+                    const size_t instances = m.id == "cube" ? (size_t(count) + 1) / 2 : size_t(count) / 2;
+                    fetch += instances * m.vertices * (mode.positionStream ? m.positionStride : m.vertexStride);
+                }
+
+                const FrameTiming ft = TimeFrames(mesh, camera, frames);
+                const RenderStats& s = mesh.GetStats();
+
+                // Streams carry the same positions, so only the layout may change the image
+                const std::vector<unsigned char> pixels = ReadFramebuffer(800, 800);
+                if (!mode.positionStream) reference = pixels;
+                const bool same = pixels == reference;
+                allSame = allSame && same;
+
+                std::cout << mode.label << fetch / (1024.0 * 1024.0) << " MB vertex fetch/frame, "
+                    << ft.frameMs << " ms frame, " << s.vaoBinds << " vao binds"
+                    << (same ? "" : ", IMAGE DIFFERS") << "\n";
+
+                mesh.Shutdown();
+            }
+
+            std::cout << "same image: " << (allSame ? "yes" : "NO") << "\n";
+            shader.Delete();
+        }
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return allSame ? 0 : 1;
+    }
+
+    // Triangles of each submesh with their vertices resolved, each rotated to start at its smallest
+    // vertex (winding kept) and sorted: equal when two meshes draw the same triangles
+    static std::vector<std::vector<float>> TriangleSet(const CpuMeshData& m)
+    {
+        std::vector<SubMesh> ranges = m.submeshes;
+        if (ranges.empty()) ranges.push_back(SubMesh{ 0, 0, (GLsizei)m.indices.size() });
+
+        std::vector<std::vector<float>> tris;
+        for (size_t r = 0; r < ranges.size(); r++)
+        {
+            for (GLsizei i = 0; i + 2 < ranges[r].indexCount; i += 3)
+            {
+                std::vector<float> v[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    const float* src = m.vertices.data() + (size_t)m.indices[ranges[r].indexOffset + i + k] * 11;
+                    v[k].assign(src, src + 11);
+                }
+
+                const int first = int(std::min_element(v, v + 3) - v);
+                std::vector<float> t{ float(r) };
+                for (int k = 0; k < 3; k++)
+                    t.insert(t.end(), v[(first + k) % 3].begin(), v[(first + k) % 3].end());
+                tris.push_back(std::move(t));
+            }
+        }
+        std::sort(tris.begin(), tris.end());
+        return tris;
+    }
+
+    // Samples that passed the depth test per covered pixel, averaged over views around the mesh
+    static double MeasureOverdraw(const CpuMeshData& data, int views)
+    {
+        glm::vec3 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+        for (size_t i = 0; i + 2 < data.vertices.size(); i += 11)
+        {
+            lo = glm::min(lo, glm::vec3(data.vertices[i], data.vertices[i + 1], data.vertices[i + 2]));
+            hi = glm::max(hi, glm::vec3(data.vertices[i], data.vertices[i + 1], data.vertices[i + 2]));
+        }
+
+        // Scaled to fit the camera's near/far range
+        const float radius = std::max(0.5f * glm::length(hi - lo), 1e-6f);
+        const float scale = 2.0f / radius;
+
+        Shader shader("Object.vert", "Object.frag");
+        MeshSystem mesh;
+        mesh.AddMesh("model", data);
+        mesh.RegisterShaderProgram("object", shader);
+        mesh.AddObjectInstance({ "Model", "model", "", "object", -0.5f * (lo + hi) * scale, glm::vec3(scale), Motion::None, 0.0f });
+        mesh.SetFrustumCulling(false);
+
+        GLuint query = 0;
+        glGenQueries(1, &query);
+
+        double total = 0.0;
+        for (int v = 0; v < views; v++)
+        {
+            // Spiral over the sphere, 6 units out, looking at the origin
+            const float y = 1.0f - 2.0f * (float(v) + 0.5f) / float(views);
+            const float a = 2.39996323f * float(v);
+            const glm::vec3 dir(std::sqrt(1.0f - y * y) * std::cos(a), y, std::sqrt(1.0f - y * y) * std::sin(a));
+
+            Camera camera(512, 512, 6.0f * dir);
+            camera.Orientation = -dir;
+            camera.Up = std::abs(y) > 0.99f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glBeginQuery(GL_SAMPLES_PASSED, query);
+            mesh.Render(camera, 0.0f);
+            glEndQuery(GL_SAMPLES_PASSED);
+
+            GLuint samples = 0;
+            glGetQueryObjectuiv(query, GL_QUERY_RESULT, &samples);
+
+            std::vector<float> depth(512 * 512);
+            glReadPixels(0, 0, 512, 512, GL_DEPTH_COMPONENT, GL_FLOAT, depth.data());
+            const size_t covered = (size_t)std::count_if(depth.begin(), depth.end(), [](float d) { return d < 1.0f; });
+
+            total += covered ? double(samples) / double(covered) : 1.0;
+        }
+
+        glDeleteQueries(1, &query);
+        mesh.Shutdown();
+        shader.Delete();
+        return total / views;
+    }
+
+    // Import-time reordering: ACMR/ATVR of the file order vs. each optimizer stage, the cost of the
+    // stages and depth-tested overdraw from views around the mesh. Must keep every triangle.
+    static int VertexCacheOrder(int argc, char** argv)
+    {
+        const std::string src = argc > 0 ? argv[0] : "Models/Testing1.obj";
+        const int views = argc > 1 ? std::max(1, std::atoi(argv[1])) : 32;
+
+        const CpuMeshData raw = ObjectLoader::LoadOBJ(src);
+        if (raw.indices.empty())
+        {
+            std::cout << "bench vertexcache: cannot read " << src << "\n";
+            return 1;
+        }
+
+        const size_t vertexCount = raw.vertices.size() / 11;
+        std::cout << "bench vertexcache: " << src << ", " << vertexCount << " vertices, "
+            << raw.indices.size() / 3 << " triangles, " << raw.submeshes.size() << " submeshes\n";
+
+        // Stage by stage on copies, each submesh on its own like MeshOptimizer::Optimize
+        std::vector<SubMesh> ranges = raw.submeshes;
+        if (ranges.empty()) ranges.push_back(SubMesh{ 0, 0, (GLsizei)raw.indices.size() });
+
+        CpuMeshData cacheOnly = raw;
+        auto t0 = Clock::now();
+        for (const SubMesh& r : ranges)
+            MeshOptimizer::OptimizeVertexCache(cacheOnly.indices.data() + r.indexOffset, (size_t)r.indexCount, vertexCount);
+        const double cacheMs = SecondsSince(t0) * 1000.0;
+
+        CpuMeshData full = raw;
+        t0 = Clock::now();
+        MeshOptimizer::Optimize(full);
+        const double fullMs = SecondsSince(t0) * 1000.0;
+
+        const bool sameTriangles = TriangleSet(raw) == TriangleSet(full) && TriangleSet(raw) == TriangleSet(cacheOnly);
+
+        struct Row { const char* label; const CpuMeshData* mesh; };
+        const Row kRows[] = {
+            { "file order:      ", &raw },
+            { "forsyth:         ", &cacheOnly },
+            { "+ overdraw/fetch:", &full },
+        };
+
+        GLFWwindow* window = InitHiddenWindow(512, 512);
+        for (const Row& row : kRows)
+        {
+            const std::vector<GLuint>& idx = row.mesh->indices;
+            const size_t vertices = row.mesh->vertices.size() / 11;
+            const VertexCacheStats s16 = MeshOptimizer::AnalyzeVertexCache(idx.data(), idx.size(), vertices, 16);
+            const VertexCacheStats s32 = MeshOptimizer::AnalyzeVertexCache(idx.data(), idx.size(), vertices, 32);
+
+            std::cout << row.label << " ACMR " << s16.acmr << " (FIFO 16), " << s32.acmr << " (32); ATVR "
+                << s16.atvr << ", " << s32.atvr;
+            if (window) std::cout << "; overdraw " << MeasureOverdraw(*row.mesh, views);
+            std::cout << "\n";
+        }
+
+        if (window)
+        {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
+
+        std::cout << "forsyth " << cacheMs << " ms, all stages " << fullMs << " ms; same triangles: "
+            << (sameTriangles ? "yes" : "NO") << "\n";
+        return sameTriangles ? 0 : 1;
+    }
+
+    static size_t LodTriangles(const std::vector<SubMesh>& submeshes)
+    {
+        size_t indices = 0;
+        for (const SubMesh& s : submeshes) indices += (size_t)s.indexCount;
+        return indices / 3;
+    }
+
+    // Import-time LOD chain of an OBJ model: triangles and error per level, simplification time
+    // serially vs. on the job system, then a field of instances receding from the camera drawn at
+    // full detail and with per-object LOD selection
+    static int LodChain(int argc, char** argv)
+    {
+        const std::string src = argc > 0 ? argv[0] : "Models/Testing1.obj";
+        const int count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+        const int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 30;
+        const int runs = 8;
+
+        CpuMeshData model = ObjectLoader::LoadOBJ(src);
+        if (model.indices.empty())
+        {
+            std::cout << "bench lod: cannot read " << src << "\n";
+            return 1;
+        }
+        MeshOptimizer::Optimize(model);     // as ImportOBJ leaves it
+
+        CpuMeshData lodded = model;
+        MeshSimplifier::GenerateLods(lodded);
+
+        std::cout << "bench lod: " << src << ", " << count << " objects, " << frames << " frames\n"
+            << "level 0: " << model.indices.size() / 3 << " triangles\n";
+        for (size_t i = 0; i < lodded.lods.size(); i++)
+        {
+            const size_t tris = LodTriangles(lodded.lods[i].submeshes);
+            std::cout << "level " << i + 1 << ": " << tris << " triangles (" << 100.0 * double(tris) / double(model.indices.size() / 3)
+                << "%), error " << lodded.lods[i].error << "\n";
+        }
+
+        // The same chain whichever threads scored the collapses
+        double bestMs[2] = { 1e30, 1e30 };
+        bool same = true;
+        JobSystem jobs;
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (int r = 0; r < runs; r++)
+            {
+                CpuMeshData m = model;
+                auto t0 = Clock::now();
+                MeshSimplifier::GenerateLods(m, pass ? &jobs : nullptr);
+                bestMs[pass] = std::min(bestMs[pass], SecondsSince(t0) * 1000.0);
+                same = same && m.indices == lodded.indices && m.lods.size() == lodded.lods.size();
+            }
+        }
+
+        std::cout << "simplify: " << bestMs[0] << " ms serial, " << bestMs[1] << " ms on " << jobs.ThreadCount()
+            << " threads; same levels: " << (same ? "yes" : "NO") << "\n";
+
+        GLFWwindow* window = InitHiddenWindow(800, 800);
+        if (!window) return same ? 0 : 1;
+
+        {
+            glm::vec3 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+            for (size_t i = 0; i + 2 < model.vertices.size(); i += 11)
+            {
+                lo = glm::min(lo, glm::vec3(model.vertices[i], model.vertices[i + 1], model.vertices[i + 2]));
+                hi = glm::max(hi, glm::vec3(model.vertices[i], model.vertices[i + 1], model.vertices[i + 2]));
+            }
+            const float scale = 0.8f / std::max(glm::length(hi - lo), 1e-6f);
+
+            Shader shader("Default.vert", "Default.frag");
+            Camera camera(800, 800, glm::vec3(0, 0, 2));
+
+            const float kThresholds[] = { 0.0f, 1.0f, 4.0f };
+            std::vector<unsigned char> reference;
+            for (const float threshold : kThresholds)
+            {
+                MeshSystem mesh;
+                mesh.AddMesh("model", lodded);
+                mesh.AddTexture("brick", "brick.jpg");
+                mesh.RegisterShaderProgram("default", shader);
+
+                // Rows receding from the camera, so projected detail falls off with distance
+                const int side = (int)std::ceil(std::sqrt((double)count));
+                for (int i = 0; i < count; i++)
+                {
+                    const glm::vec3 pos(float(i % side) - 0.5f * float(side), -0.5f, -float(i / side) * 0.5f);
+                    mesh.AddObjectInstance({ "Model" + std::to_string(i), "model", "brick", "default",
+                        pos - scale * 0.5f * (lo + hi), glm::vec3(scale), Motion::RotateY, 30.0f });
+                }
+
+                mesh.SetLodThreshold(threshold);
+                const FrameTiming ft = TimeFrames(mesh, camera, frames);
+                const RenderStats& st = mesh.GetStats();
+
+                const std::vector<unsigned char> pixels = ReadFramebuffer(800, 800);
+                if (reference.empty()) reference = pixels;
+
+                size_t differing = 0, diffSum = 0;
+                for (size_t i = 0; i < pixels.size(); i += 3)
+                {
+                    int d = 0;
+                    for (size_t c = 0; c < 3; c++)
+                        d = std::max(d, std::abs(int(pixels[i + c]) - int(reference[i + c])));
+                    if (d > 0) differing++;
+                    diffSum += (size_t)d;
+                }
+
+                std::cout << "threshold " << threshold << " px: " << st.triangles << " triangles, " << st.coarseLods << " of "
+                    << st.visible << " visible objects coarser; " << ft.cpuMs << " ms cpu, " << ft.frameMs << " ms frame; "
+                    << differing << " pixels differ, mean " << double(diffSum) / double(pixels.size() / 3) << "/255\n";
+
+                mesh.Shutdown();
+            }
+
+            shader.Delete();
+        }
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return same ? 0 : 1;
+    }
+
+    // Meshlets of an OBJ model: triangles drawn and frame time with cluster culling off, by frustum,
+    // and by frustum and normal cone, through the draw loop and (GL 4.3) multi-draw indirect.
+    // Close-up: the camera sits inside the model a quarter of the way in from its front (-z) face,
+    // looking out through it, so the frustum planes cut the model and the meshlets behind and beside
+    // the view must be culled. Field: copies that all fit in the view have nothing to cull and must
+    // stay instanced, in as many batches as with culling off.
+    static int ClusterCulling(int argc, char** argv)
+    {
+        const std::string src = argc > 0 ? argv[0] : "Models/Testing1.obj";
+        const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 30;
+        const int fieldSide = 26;
+
+        CpuMeshData model = ObjectLoader::LoadOBJ(src);
+        if (model.indices.empty())
+        {
+            std::cout << "bench clusters: cannot read " << src << "\n";
+            return 1;
+        }
+        MeshOptimizer::Optimize(model);     // as ImportOBJ leaves it
+
+        auto t0 = Clock::now();
+        const size_t meshletCount = MeshletBuilder::Build(model);
+        const double buildMs = SecondsSince(t0) * 1000.0;
+
+        std::cout << "bench clusters: " << src << ", " << model.indices.size() / 3 << " triangles, "
+            << meshletCount << " meshlets built in " << buildMs << " ms, " << frames << " frames\n";
+
+        GLFWwindow* window = InitHiddenWindow(800, 800);
+        if (!window) return 1;
+
+        bool frustumSame = true, closeUpCulled = true, fieldInstanced = true;
+        {
+            glm::vec3 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+            for (size_t i = 0; i + 2 < model.vertices.size(); i += 11)
+            {
+                lo = glm::min(lo, glm::vec3(model.vertices[i], model.vertices[i + 1], model.vertices[i + 2]));
+                hi = glm::max(hi, glm::vec3(model.vertices[i], model.vertices[i + 1], model.vertices[i + 2]));
+            }
+            const glm::vec3 center = 0.5f * (lo + hi);
+            float radius = 0.0f;
+            for (size_t i = 0; i + 2 < model.vertices.size(); i += 11)
+                radius = std::max(radius, glm::length(glm::vec3(model.vertices[i], model.vertices[i + 1], model.vertices[i + 2]) - center));
+            radius = std::max(radius, 1e-6f);
+
+            const glm::vec3 eye(0.0f, 0.0f, 2.0f);
+            Shader shader("Default.vert", "Default.frag");
+            Camera camera(800, 800, eye);
+
+            struct Mode { const char* name; bool clusters; bool cones; };
+            const Mode kModes[] = { { "off", false, false }, { "frustum", true, false }, { "frustum+cone", true, true } };
+
+            for (int field = 0; field < 2; field++)
+            {
+                for (int indirect = 0; indirect < 2; indirect++)
+                {
+                    std::vector<unsigned char> reference;
+                    unsigned int offBatches = 0;
+                    for (const Mode& mode : kModes)
+                    {
+                        MeshSystem mesh;
+                        mesh.AddMesh("model", model);
+                        mesh.AddTexture("brick", "brick.jpg");
+                        mesh.RegisterShaderProgram("default", shader);
+
+                        if (!field)
+                        {
+                            // Bounding radius 3, the eye inside near the front
+                            const float scale = 3.0f / radius;
+                            const glm::vec3 inside(center.x, center.y, lo.z + 0.25f * (hi.z - lo.z));
+                            mesh.AddObjectInstance({ "Model", "model", "brick", "default", eye - scale * inside, glm::vec3(scale) });
+                        }
+                        else
+                        {
+                            // Radius 0.1 on a 0.22 grid 8 units ahead: the whole field is in view
+                            const float scale = 0.1f / radius;
+                            for (int i = 0; i < fieldSide * fieldSide; i++)
+                            {
+                                const glm::vec3 cell(0.22f * (float(i % fieldSide) - 0.5f * float(fieldSide - 1)),
+                                    0.22f * (float(i / fieldSide) - 0.5f * float(fieldSide - 1)), eye.z - 8.0f);
+                                mesh.AddObjectInstance({ "Model" + std::to_string(i), "model", "brick", "default",
+                                    cell - scale * center, glm::vec3(scale), Motion::RotateY, 30.0f });
+                            }
+                        }
+
+                        if (indirect && !mesh.SetIndirectDraw(true))
+                        {
+                            mesh.Shutdown();
+                            break;
+                        }
+                        mesh.SetLodThreshold(0.0f);
+                        mesh.SetClusterCulling(mode.clusters);
+                        mesh.SetClusterConeCulling(mode.cones);
+
+                        const FrameTiming ft = TimeFrames(mesh, camera, frames);
+                        const RenderStats& st = mesh.GetStats();
+
+                        const std::vector<unsigned char> pixels = ReadFramebuffer(800, 800);
+                        if (reference.empty())
+                        {
+                            reference = pixels;
+                            offBatches = st.batches;
+                        }
+
+                        size_t differing = 0;
+                        for (size_t i = 0; i < pixels.size(); i += 3)
+                            if (pixels[i] != reference[i] || pixels[i + 1] != reference[i + 1] || pixels[i + 2] != reference[i + 2])
+                                differing++;
+
+                        if (mode.clusters && !mode.cones && differing > 0) frustumSame = false;
+                        if (mode.clusters && !field && st.clustersCulled == 0) closeUpCulled = false;
+                        if (mode.clusters && !mode.cones && field && st.batches != offBatches) fieldInstanced = false;
+
+                        std::cout << (field ? "field " : "close-up ") << (indirect ? "indirect " : "draw loop ") << mode.name << ": "
+                            << st.triangles << " triangles, " << st.clustersVisible << " clusters drawn, " << st.clustersCulled
+                            << " culled, " << st.batches << " batches, " << st.drawCalls << " draw calls; " << ft.cpuMs
+                            << " ms cpu, " << ft.frameMs << " ms frame; " << differing << " pixels differ from off\n";
+
+                        mesh.Shutdown();
+                    }
+                }
+            }
+
+            shader.Delete();
+        }
+
+        std::cout << "frustum culled frames match: " << (frustumSame ? "yes" : "NO")
+            << "; close-up culls clusters: " << (closeUpCulled ? "yes" : "NO")
+            << "; field stays instanced: " << (fieldInstanced ? "yes" : "NO") << "\n";
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return frustumSame && closeUpCulled && fieldInstanced ? 0 : 1;
+    }
+
+    // Render CPU time on a large animated scene from 1 thread up to maxThreads (doubling):
+    // flat SIMD culling of every object, then every object drawn with culling off
+    static int RenderJobs(int argc, char** argv)
+    {
+        const int count = argc > 0 ? std::max(1, std::atoi(argv[0])) : 100000;
+        const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+        const unsigned int hw = std::max(1u, std::thread::hardware_concurrency());
+        const unsigned int maxThreads = argc > 2 ? (unsigned int)std::max(1, std::atoi(argv[2])) : hw;
+
+        GLFWwindow* window = InitHiddenWindow(800, 800);
+        if (!window) return 1;
+
+        bool allSame = true;
+        {
+            Shader shader("Default.vert", "Default.frag");
+            Camera camera(800, 800, glm::vec3(0, 0, 2));
+
+            MeshSystem mesh;
+            mesh.AddPrimitiveMesh("cube", gfx::ShapeType::Cube);
+            mesh.AddPrimitiveMesh("circle", gfx::ShapeType::Circle);
+            mesh.AddTexture("brick", "brick.jpg");
+            mesh.AddTexture("metal", "metal.jpg");
+            mesh.AddTexture("anime", "poza.jpg");
+            mesh.RegisterShaderProgram("default", shader);
+            SpawnGridScene(mesh, count);
+            mesh.SetBvhCulling(false);
+
+            std::cout << "bench jobs: " << count << " objects, " << frames << " frames, "
+                << hw << " hardware threads\n";
+
+            std::vector<unsigned int> counts;
+            for (unsigned int t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+            counts.push_back(maxThreads);
+
+            double serialCulled = 0.0, serialAll = 0.0;
+            unsigned int visible = 0;
+
+            for (unsigned int t : counts)
+            {
+                JobSystem jobs(t);
+                mesh.SetJobSystem(&jobs);
+
+                mesh.SetFrustumCulling(true);
+                const FrameTiming culled = TimeFrames(mesh, camera, frames);
+                if (t == 1) visible = mesh.GetStats().visible;
+                else allSame = allSame && visible == mesh.GetStats().visible;
+
+                mesh.SetFrustumCulling(false);
+                const FrameTiming all = TimeFrames(mesh, camera, frames);
+
+                if (t == 1) { serialCulled = culled.cpuMs; serialAll = all.cpuMs; }
+
+                std::cout << "threads " << t << ": culled " << culled.cpuMs << " ms cpu ("
+                    << serialCulled / culled.cpuMs << "x), unculled " << all.cpuMs << " ms cpu ("
+                    << serialAll / all.cpuMs << "x)\n";
+
+                mesh.SetJobSystem(nullptr);
+            }
+
+            std::cout << "same visible set: " << (allSame ? "yes" : "NO") << "\n";
+
+            mesh.Shutdown();
+            shader.Delete();
+        }
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return allSame ? 0 : 1;
+    }
+
+    struct LoopSamples
+    {
+        std::vector<double> frameMs;    // swap to swap
+        std::vector<double> latencyMs;  // input sample to glFinish of the frame showing it
+    };
+
+    static void PrintLoopSamples(const char* label, std::vector<double> frameMs, std::vector<double> latencyMs)
+    {
+        auto meanOf = [](const std::vector<double>& v)
+        {
+            double sum = 0.0;
+            for (double x : v) sum += x;
+            return v.empty() ? 0.0 : sum / double(v.size());
+        };
+        auto p99Of = [](std::vector<double>& v)
+        {
+            if (v.empty()) return 0.0;
+            std::sort(v.begin(), v.end());
+            return v[std::min(v.size() - 1, v.size() * 99 / 100)];
+        };
+
+        const double frameMean = meanOf(frameMs);
+        double var = 0.0;
+        for (double x : frameMs) var += (x - frameMean) * (x - frameMean);
+        var = frameMs.empty() ? 0.0 : var / double(frameMs.size());
+
+        std::cout << label << "frame " << frameMean << " ms mean, " << std::sqrt(var) << " ms stddev, "
+            << p99Of(frameMs) << " ms p99; latency " << meanOf(latencyMs) << " ms mean, "
+            << p99Of(latencyMs) << " ms p99\n";
+    }
+
+    // Update and render on one thread vs. the update on a SimulationThread, with synthetic camera
+    // input and every tenth update stalled by stallMs. "Photon" = glFinish after the frame's draws.
+    static int SimulationLatency(int argc, char** argv)
+    {
+        const int count = argc > 0 ? std::max(1, std::atoi(argv[0])) : 20000;
+        const int frames = argc > 1 ? std::max(20, std::atoi(argv[1])) : 300;
+        const int stallMs = argc > 2 ? std::max(0, std::atoi(argv[2])) : 20;
+        const int warmup = 10;
+
+        GLFWwindow* window = InitHiddenWindow(800, 800);
+        if (!window) return 1;
+
+        {
+            Shader shader("Default.vert", "Default.frag");
+            Camera camera(800, 800, glm::vec3(0, 0, 2));
+
+            MeshSystem mesh;
+            mesh.AddPrimitiveMesh("cube", gfx::ShapeType::Cube);
+            mesh.AddPrimitiveMesh("circle", gfx::ShapeType::Circle);
+            mesh.AddTexture("brick", "brick.jpg");
+            mesh.AddTexture("metal", "metal.jpg");
+            mesh.AddTexture("anime", "poza.jpg");
+            mesh.RegisterShaderProgram("default", shader);
+            SpawnGridScene(mesh, count);
+
+            std::cout << "bench sim: " << count << " objects, " << frames << " frames, "
+                << stallMs << " ms stall every 10th update\n";
+
+            auto stall = [stallMs](uint64_t update)
+            {
+                if (stallMs > 0 && update % 10 == 9)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(stallMs));
+            };
+            auto turn = [&camera]() { camera.Orientation = glm::rotate(camera.Orientation, glm::radians(0.2f), camera.Up); };
+
+            // Serial: sample, update, draw, all in one frame
+            {
+                LoopSamples s;
+                Clock::time_point last = Clock::now();
+                for (int f = 0; f < frames; f++)
+                {
+                    const Clock::time_point sampled = Clock::now();
+                    turn();
+                    stall((uint64_t)f);
+
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    mesh.Render(camera, float(f) / 60.0f);
+                    glFinish();
+                    glfwSwapBuffers(window);
+
+                    const Clock::time_point now = Clock::now();
+                    if (f >= warmup)
+                    {
+                        s.frameMs.push_back(std::chrono::duration<double, std::milli>(now - last).count());
+                        s.latencyMs.push_back(std::chrono::duration<double, std::milli>(now - sampled).count());
+                    }
+                    last = now;
+                }
+                PrintLoopSamples("serial:   ", s.frameMs, s.latencyMs);
+            }
+
+            // Threaded: this thread samples and submits, the update builds snapshots
+            {
+                LoopSamples s;
+                uint64_t updates = 0;
+
+                SimulationThread sim;
+                sim.Start([&](const InputSample& in, SceneSnapshot& out)
+                {
+                    stall(updates++);
+                    mesh.Prepare(out.render, in.camera, in.timeSec);
+                    out.inputSampledAt = in.sampledAt;
+                });
+
+                InputSample input;
+                Clock::time_point last = Clock::now();
+                for (int f = 0; f < frames; f++)
+                {
+                    turn();
+                    input.camera = camera;
+                    input.timeSec = float(f) / 60.0f;
+                    input.sampledAt = Clock::now();
+                    sim.PublishInput(input);
+
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    const SceneSnapshot* frame = sim.LatestSnapshot();
+                    if (frame) mesh.Submit(frame->render);
+                    glFinish();
+                    glfwSwapBuffers(window);
+
+                    const Clock::time_point now = Clock::now();
+                    if (f >= warmup && frame)
+                    {
+                        s.frameMs.push_back(std::chrono::duration<double, std::milli>(now - last).count());
+                        s.latencyMs.push_back(std::chrono::duration<double, std::milli>(now - frame->inputSampledAt).count());
+                    }
+                    last = now;
+                }
+
+                sim.Stop();
+                PrintLoopSamples("threaded: ", s.frameMs, s.latencyMs);
+            }
+
+            mesh.Shutdown();
+            shader.Delete();
+        }
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 0;
+    }
+
+    // Unit boxes on a ground grid of constant density, so the camera sees about the same
+    // number of them whatever the scene size; every fifth box bobs
+    static std::vector<SceneBvh::Item> GridBoxes(int count, float t)
+    {
+        const int side = (int)std::ceil(std::sqrt((double)count));
+        const float spacing = 2.0f;
+
+        std::vector<SceneBvh::Item> items(count);
+        for (int i = 0; i < count; i++)
+        {
+            const float bob = (i % 5 == 0) ? 0.5f * std::sin(2.0f * t + float(i)) : 0.0f;
+            const glm::vec3 c((float(i % side) - 0.5f * side) * spacing, bob, (float(i / side) - 0.5f * side) * spacing);
+
+            items[i].min = c - glm::vec3(0.5f);
+            items[i].max = c + glm::vec3(0.5f);
+            items[i].id = (uint32_t)i;
+        }
+        return items;
+    }
+
+    static bool BruteRaycast(const std::vector<SceneBvh::Item>& items, const glm::vec3& origin, const glm::vec3& dir, uint32_t& hitId)
+    {
+        const glm::vec3 inv = 1.0f / dir;
+        float best = std::numeric_limits<float>::max();
+        bool hit = false;
+
+        for (const SceneBvh::Item& it : items)
+        {
+            const glm::vec3 t0 = (it.min - origin) * inv, t1 = (it.max - origin) * inv;
+            const glm::vec3 lo = glm::min(t0, t1), hi = glm::max(t0, t1);
+            const float enter = std::max({ lo.x, lo.y, lo.z });
+            const float exit = std::min({ hi.x, hi.y, hi.z });
+
+            if (enter >= 0.0f && enter <= exit && enter < best)
+            {
+                best = enter;
+                hitId = it.id;
+                hit = true;
+            }
+        }
+        return hit;
+    }
+
+    // BVH vs. flat scans for frustum culling and ray picking, at growing object counts
+    static int BvhQueries(int argc, char** argv)
+    {
+        const int maxCount = argc > 0 ? std::max(1000, std::atoi(argv[0])) : 100000;
+        const int queries = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1000;
+
+        Camera camera(800, 800, glm::vec3(0.0f, 2.0f, 0.0f));
+        const Frustum frustum = Frustum::FromMatrix(camera.ViewProjection(45.0f, 0.1f, 50.0f));
+
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> spread(-0.4f, 0.4f);
+        std::vector<glm::vec3> rays(queries);
+        for (glm::vec3& d : rays)
+            d = glm::normalize(glm::vec3(spread(rng), -0.1f + 0.5f * spread(rng), -1.0f));
+
+        std::cout << "bench bvh: " << queries << " rays per size\n";
+
+        for (int count = 1000; count <= maxCount; count *= 10)
+        {
+            const std::vector<SceneBvh::Item> items = GridBoxes(count, 0.0f);
+
+            auto t0 = Clock::now();
+            SceneBvh bvh;
+            bvh.Build(items);
+            const double buildMs = SecondsSince(t0) * 1000.0;
+
+            // Refit after the bobbing fifth moved
+            const std::vector<SceneBvh::Item> moved = GridBoxes(count, 0.5f);
+            t0 = Clock::now();
+            for (int i = 0; i < count; i += 5)
+                bvh.Update(moved[i].id, moved[i].min, moved[i].max);
+            bvh.Refit();
+            const double refitMs = SecondsSince(t0) * 1000.0;
+
+            // Flat SIMD cull over SoA bounds
+            std::vector<float> cx(count), cy(count), cz(count), r(count), e(count, 0.5f);
+            for (int i = 0; i < count; i++)
+            {
+                const glm::vec3 c = 0.5f * (moved[i].min + moved[i].max);
+                cx[i] = c.x; cy[i] = c.y; cz[i] = c.z;
+                r[i] = std::sqrt(0.75f);
+            }
+            std::vector<uint8_t> visible(count);
+            const CullBounds b{ cx.data(), cy.data(), cz.data(), r.data(), e.data(), e.data(), e.data() };
+
+            const int cullRuns = 50;
+            size_t flatVisible = 0;
+            t0 = Clock::now();
+            for (int k = 0; k < cullRuns; k++)
+                flatVisible = CullBoundsAgainstFrustum(frustum, b, count, visible.data());
+            const double flatCullUs = SecondsSince(t0) * 1e6 / cullRuns;
+
+            std::vector<uint32_t> ids;
+            size_t visited = 0;
+            t0 = Clock::now();
+            for (int k = 0; k < cullRuns; k++)
+            {
+                ids.clear();
+                visited = bvh.Cull(frustum, ids);
+            }
+            const double bvhCullUs = SecondsSince(t0) * 1e6 / cullRuns;
+
+            // Rays from the camera; both paths must agree on the nearest box
+            int mismatches = 0, hits = 0;
+            t0 = Clock::now();
+            for (const glm::vec3& d : rays)
+            {
+                uint32_t id;
+                float dist;
+                hits += bvh.Raycast(camera.Position, d, std::numeric_limits<float>::max(), id, dist) ? 1 : 0;
+            }
+            const double bvhRayUs = SecondsSince(t0) * 1e6 / queries;
+
+            t0 = Clock::now();
+            for (const glm::vec3& d : rays)
+            {
+                uint32_t a = 0, c = 0;
+                float dist;
+                const bool hb = BruteRaycast(moved, camera.Position, d, a);
+                const bool hv = bvh.Raycast(camera.Position, d, std::numeric_limits<float>::max(), c, dist);
+                if (hb != hv || (hb && a != c)) mismatches++;
+            }
+            const double flatRayUs = SecondsSince(t0) * 1e6 / queries - bvhRayUs;
+
+            std::cout << count << " objects: build " << buildMs << " ms, refit " << refitMs << " ms\n"
+                << "  cull: flat " << flatCullUs << " us (" << flatVisible << " visible), bvh " << bvhCullUs
+                << " us (" << ids.size() << " visible, " << visited << "/" << bvh.NodeCount() << " nodes)\n"
+                << "  ray:  flat " << flatRayUs << " us, bvh " << bvhRayUs << " us, "
+                << hits << " hits, " << mismatches << " mismatches\n";
+        }
+
+        return 0;
+    }
+
+    // Per-frame object lookups (handle, name index, old linear scan) at growing scene sizes
+    static int ObjectLookup(int argc, char** argv)
+    {
+        const int maxCount = argc > 0 ? std::max(1000, std::atoi(argv[0])) : 100000;
+        const int lookups = 100000;
+
+        std::cout << "bench lookup: " << lookups << " lookups per size\n";
+
+        for (int count = 1000; count <= maxCount; count *= 10)
+        {
+            MeshSystem mesh;
+            std::vector<ObjectHandle> handles;
+            for (int i = 0; i < count; i++)
+            {
+                SceneObjectDesc o;
+                o.name = "Obj" + std::to_string(i);
+                handles.push_back(mesh.AddObjectInstance(o));
+            }
+
+            // Churn: remove every third object, re-add as many; old handles must go stale
+            int staleOk = 0, liveOk = 0;
+            for (int i = 0; i < count; i += 3) mesh.RemoveObject(handles[i]);
+            for (int i = 0; i < count; i += 3)
+            {
+                SceneObjectDesc o;
+                o.name = "New" + std::to_string(i);
+                mesh.AddObjectInstance(o);
+            }
+            for (int i = 0; i < count; i++)
+            {
+                SceneObject* o = mesh.GetObject(handles[i]);
+                if (i % 3 == 0) staleOk += o == nullptr;
+                else liveOk += o && mesh.GetObjectName(handles[i]) == "Obj" + std::to_string(i);
+            }
+
+            const std::string name = "Obj" + std::to_string(count - 1);
+            const ObjectHandle h = handles[count - 1];
+            volatile size_t sink = 0;   // keeps the timed lookups from being optimized away
+
+            auto t0 = Clock::now();
+            for (int k = 0; k < lookups; k++) sink = sink + (mesh.GetObject(h) != nullptr);
+            const double handleNs = SecondsSince(t0) * 1e9 / lookups;
+
+            t0 = Clock::now();
+            for (int k = 0; k < lookups; k++) sink = sink + (mesh.FindObject(name) != nullptr);
+            const double nameNs = SecondsSince(t0) * 1e9 / lookups;
+
+            // What FindObject used to do: compare names front to back (last object = worst case)
+            std::vector<std::string> names;
+            for (int i = 0; i < count; i++) names.push_back("Obj" + std::to_string(i));
+            const int scanLookups = std::max(10, lookups / count);
+            t0 = Clock::now();
+            for (int k = 0; k < scanLookups; k++)
+                for (const std::string& n : names)
+                    if (n == name) { sink = sink + 1; break; }
+            const double scanNs = SecondsSince(t0) * 1e9 / scanLookups;
+
+            std::cout << count << " objects: handle " << handleNs << " ns, name " << nameNs
+                << " ns, linear scan " << scanNs << " ns; after churn " << staleOk << " stale, "
+                << liveOk << " live handles ok\n";
+        }
+
+        return 0;
+    }
+
+    // The per-object glm path Render used before TransformStore, kept as the reference
+    static glm::mat4 LegacyModelMatrix(const SceneObject& o, float t)
+    {
+        glm::vec3 p = o.pos;
+        if (o.motion == Motion::BobY)
+            p = o.basePos + glm::vec3(0.0f, o.bobAmp * sinf(t * o.bobFreq), 0.0f);
+
+        glm::mat4 model(1.0f);
+        model = glm::translate(model, p);
+
+        if (o.motion == Motion::RotateX)
+            model = glm::rotate(model, glm::radians(t * o.rotSpeedDeg), glm::vec3(1, 0, 0));
+        else if (o.motion == Motion::RotateY)
+            model = glm::rotate(model, glm::radians(t * o.rotSpeedDeg), glm::vec3(0, 1, 0));
+        else if (o.motion == Motion::RotateXY)
+        {
+            model = glm::rotate(model, glm::radians(t * o.rotSpeedDeg), glm::vec3(1, 0, 0));
+            model = glm::rotate(model, glm::radians(t * o.rotSpeedDeg * 0.7f), glm::vec3(0, 1, 0));
+        }
+
+        return glm::scale(model, o.scale);
+    }
+
+    // Matrices per second: legacy glm per object vs. SoA SIMD batches, for all objects in
+    // storage order and for a shuffled tenth (what a culled, sorted frame asks for)
+    static int TransformMatrices(int argc, char** argv)
+    {
+        const int count = argc > 0 ? std::max(16, std::atoi(argv[0])) : 100000;
+        const int runs = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+
+        static const Motion kMotions[] = { Motion::None, Motion::RotateX, Motion::RotateY, Motion::RotateXY, Motion::BobY };
+
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+        std::vector<SceneObject> objects(count);
+        TransformStore store;
+        for (int i = 0; i < count; i++)
+        {
+            SceneObject& o = objects[i];
+            o.pos = glm::vec3(unit(rng), unit(rng), unit(rng)) * 20.0f;
+            o.basePos = o.pos;
+            o.scale = glm::vec3(0.5f + 0.5f * std::abs(unit(rng)));
+            o.motion = kMotions[i % 5];
+            o.rotSpeedDeg = 90.0f * unit(rng);
+            o.bobAmp = 0.25f;
+            o.bobFreq = 2.0f;
+            store.Add(o);
+        }
+
+        std::vector<uint32_t> all(count);
+        for (int i = 0; i < count; i++) all[i] = (uint32_t)i;
+        std::vector<uint32_t> subset = all;
+        std::shuffle(subset.begin(), subset.end(), rng);
+        subset.resize(count / 10);
+
+        std::vector<glm::mat4> legacy(count), simd(count);
+
+        std::cout << "bench transforms: " << count << " objects, " << runs << " runs\n";
+
+        for (const std::vector<uint32_t>* ids : { &all, &subset })
+        {
+            const size_t n = ids->size();
+            double legacyS = 0.0, simdS = 0.0;
+            float maxError = 0.0f;
+
+            for (int r = 0; r < runs; r++)
+            {
+                const float t = 0.37f + 1.7f * float(r);
+
+                auto t0 = Clock::now();
+                for (size_t i = 0; i < n; i++)
+                    legacy[i] = LegacyModelMatrix(objects[(*ids)[i]], t);
+                legacyS += SecondsSince(t0);
+
+                t0 = Clock::now();
+                store.Evaluate(ids->data(), n, t, simd.data());
+                simdS += SecondsSince(t0);
+
+                for (size_t i = 0; i < n; i++)
+                    for (int c = 0; c < 4; c++)
+                        for (int e = 0; e < 4; e++)
+                            maxError = std::max(maxError, std::abs(legacy[i][c][e] - simd[i][c][e]));
+            }
+
+            const double total = double(n) * runs;
+            std::cout << (ids == &all ? "all, in order:     " : "tenth, shuffled:   ")
+                << "glm " << total / legacyS / 1e6 << " M/s, soa " << total / simdS / 1e6
+                << " M/s (" << legacyS / simdS << "x), max abs error " << maxError << "\n";
+        }
+
+        return 0;
+    }
+
+    int Run(int argc, char** argv)
+    {
+        const char* name = argc > 0 ? argv[0] : "";
+
+        if (std::strcmp(name, "obj") == 0) return ObjLoad(argc - 1, argv + 1);
+        if (std::strcmp(name, "objmt") == 0) return ObjLoadThreads(argc - 1, argv + 1);
+        if (std::strcmp(name, "meshcache") == 0) return MeshCacheLoad(argc - 1, argv + 1);
+        if (std::strcmp(name, "vertexcache") == 0) return VertexCacheOrder(argc - 1, argv + 1);
+        if (std::strcmp(name, "lod") == 0) return LodChain(argc - 1, argv + 1);
+        if (std::strcmp(name, "clusters") == 0) return ClusterCulling(argc - 1, argv + 1);
+        if (std::strcmp(name, "render") == 0) return RenderInstancing(argc - 1, argv + 1);
+        if (std::strcmp(name, "indirect") == 0) return IndirectSubmission(argc - 1, argv + 1);
+        if (std::strcmp(name, "gpucull") == 0) return GpuCulling(argc - 1, argv + 1);
+        if (std::strcmp(name, "stream") == 0) return StreamUploads(argc - 1, argv + 1);
+        if (std::strcmp(name, "vertexformat") == 0) return VertexFormats(argc - 1, argv + 1);
+        if (std::strcmp(name, "positions") == 0) return PositionStreams(argc - 1, argv + 1);
+        if (std::strcmp(name, "jobs") == 0) return RenderJobs(argc - 1, argv + 1);
+        if (std::strcmp(name, "sim") == 0) return SimulationLatency(argc - 1, argv + 1);
+        if (std::strcmp(name, "bvh") == 0) return BvhQueries(argc - 1, argv + 1);
+        if (std::strcmp(name, "lookup") == 0) return ObjectLookup(argc - 1, argv + 1);
+        if (std::strcmp(name, "transforms") == 0) return TransformMatrices(argc - 1, argv + 1);
+
+        std::cout << "usage: --bench <name> [args]\n"
+            << "  obj [path] [copies] [runs]          OBJ loader throughput (MB/s)\n"
+            << "  objmt [path] [copies] [maxThreads]  chunked OBJ loader thread scaling\n"
+            << "  meshcache [path] [copies] [runs]    binary mesh cache hit vs. text parse\n"
+            << "  render [objects] [frames]           per-object vs. instanced vs. unculled vs. GPU motion (needs GL)\n"
+            << "  indirect [objects] [frames]         submit CPU time, draw loop vs. multi-draw indirect (needs GL 4.3)\n"
+            << "  gpucull [objects] [frames]          CPU culling vs. compute shader culling (needs GL 4.3)\n"
+            << "  stream [objects] [frames]           per-frame uploads: orphaning vs. subdata vs. fenced ring (needs GL)\n"
+            << "  vertexformat [objects] [frames] [obj] vertex bytes and frame time, full vs. compact vertices (needs GL)\n"
+            << "  positions [objects] [frames]        position-only shader, interleaved vs. position stream (needs GL)\n"
+            << "  vertexcache [path] [views]          ACMR/ATVR and overdraw, file order vs. MeshOptimizer\n"
+            << "  lod [path] [objects] [frames]       LOD chain per level, simplify time, full detail vs. LOD selection\n"
+            << "  clusters [path] [frames]            meshlet culling off vs. frustum vs. frustum + normal cone, close-up and field (needs GL)\n"
+            << "  jobs [objects] [frames] [maxThreads] render CPU time vs. job system threads (needs GL)\n"
+            << "  sim [objects] [frames] [stallMs]    input latency and frame time, serial vs. sim thread (needs GL)\n"
+            << "  bvh [maxObjects] [rays]             BVH vs. flat culling and ray picking\n"
+            << "  lookup [maxObjects]                 object handle and name lookups vs. linear scan\n"
+            << "  transforms [objects] [runs]         model matrices/s, glm per object vs. SoA SIMD\n";
+        return 1;
+    }
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// Offline benchmarks, started with: <exe> --bench <name> [args...]
+namespace bench
+{
+    int Run(int argc, char** argv);
+}
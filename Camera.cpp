@@ -11,12 +11,17 @@ Camera::Camera(int width, int height, glm::vec3 position)
 {
 }
 
-void Camera::Matrix(float FOVdeg, float nearPlane, float farPlane, Shader& shader, const char* uniform)
+glm::mat4 Camera::ViewProjection(float FOVdeg, float nearPlane, float farPlane) const
 {
     const glm::mat4 view = glm::lookAt(Position, Position + Orientation, Up);
     const glm::mat4 proj = glm::perspective(glm::radians(FOVdeg), float(width) / float(height), nearPlane, farPlane);
+    return proj * view;
+}
 
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, uniform), 1, GL_FALSE, glm::value_ptr(proj * view));
+void Camera::Matrix(float FOVdeg, float nearPlane, float farPlane, Shader& shader, const char* uniform)
+{
+    glUniformMatrix4fv(glGetUniformLocation(shader.ID, uniform), 1, GL_FALSE,
+        glm::value_ptr(ViewProjection(FOVdeg, nearPlane, farPlane)));
 }
 
 void Camera::Inputs(GLFWwindow* window)
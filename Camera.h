@@ -30,6 +30,7 @@ public:
 
     Camera(int width, int height, glm::vec3 position);
 
+    glm::mat4 ViewProjection(float FOVdeg, float nearPlane, float farPlane) const;
     void Matrix(float FOVdeg, float nearPlane, float farPlane, Shader& shader, const char* uniform);
     void Inputs(GLFWwindow* window);
 };
@@ -8,22 +8,29 @@ in vec3 Normal;
 in vec3 crntPos;
 
 uniform sampler2D tex0;
-uniform vec4 lightColor;
-uniform vec3 lightPos;
-uniform vec3 camPos;
+uniform vec3 diffuseColor;
+
+layout (std140) uniform FrameData	// per frame, see FrameUniforms in Mesh.h
+{
+	mat4 camMatrix;
+	vec4 camPos;		// xyz
+	vec4 lightColor;
+	vec4 lightPos;		// xyz
+	vec4 motionTime;	// x = seconds, y = 1 when ModelMatrix() animates from motionParams
+};
 
 void main()
 {
 	float ambient = 0.20f;
 	vec3 normal = normalize(Normal);
-	vec3 lightDirection = normalize(lightPos - crntPos);
+	vec3 lightDirection = normalize(lightPos.xyz - crntPos);
 	float diffuse = max(dot(normal, lightDirection), 0.0f);
 
 	float specularLight = 0.50f;
-	vec3 viewDirection = normalize(camPos - crntPos);
+	vec3 viewDirection = normalize(camPos.xyz - crntPos);
 	vec3 reflectionDirection = reflect(-lightDirection, normal);
 	float specAmount = pow(max(dot(viewDirection, reflectionDirection), 0.0f), 8);
 	float specular = specAmount * specularLight;
 
-	FragColor = texture(tex0, texCoord) * lightColor * (diffuse + ambient + specular);
+	FragColor = texture(tex0, texCoord) * vec4(diffuseColor, 1.0f) * lightColor * (diffuse + ambient + specular);
 }
\ No newline at end of file
@@ -11,15 +11,27 @@ out vec2 texCoord;
 out vec3 Normal;
 out vec3 crntPos;
 
-uniform mat4 camMatrix;
-uniform mat4 model;
+#include "VertexCommon.glsl"
+
+// Octahedral normals arrive as xy on the [-1, 1] square, see OctahedralEncode in VertexLayout.cpp
+vec3 DecodeNormal()
+{
+	if (vertexDecode[0].w == 0.0)
+		return aNormal;
+
+	vec3 n = vec3(aNormal.xy, 1.0 - abs(aNormal.x) - abs(aNormal.y));
+	if (n.z < 0.0)
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
 
 
 void main()
 {
-	crntPos = vec3(model * vec4(aPos, 1.0f));
+	vec3 pos = aPos * vertexDecode[0].xyz + vertexDecode[1].xyz;
+	crntPos = vec3(ModelMatrix() * vec4(pos, 1.0f));
 	gl_Position = camMatrix * vec4(crntPos, 1.0);
 	color = aColor;
 	texCoord = aTex;
-	Normal = aNormal;
+	Normal = DecodeNormal();
 }
\ No newline at end of file
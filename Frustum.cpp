@@ -0,0 +1,140 @@
+#include "Frustum.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FRUSTUM_SSE 1
+#endif
+
+Frustum Frustum::FromMatrix(const glm::mat4& m)
+{
+    // Gribb/Hartmann: rows of the clip matrix combined pairwise (glm is column-major)
+    const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum f;
+    f.planes[0] = row3 + row0;  // left
+    f.planes[1] = row3 - row0;  // right
+    f.planes[2] = row3 + row1;  // bottom
+    f.planes[3] = row3 - row1;  // top
+    f.planes[4] = row3 + row2;  // near
+    f.planes[5] = row3 - row2;  // far
+
+    for (glm::vec4& p : f.planes)
+        p /= glm::length(glm::vec3(p));
+
+    return f;
+}
+
+Frustum Frustum::Transformed(const glm::mat4& model) const
+{
+    // Planes are covectors: a world plane p holds local points x with dot(p, model * x) = dot(model^T p, x)
+    const glm::mat4 t = glm::transpose(model);
+
+    Frustum f;
+    for (int i = 0; i < 6; i++)
+    {
+        f.planes[i] = t * planes[i];
+        f.planes[i] /= glm::length(glm::vec3(f.planes[i]));
+    }
+    return f;
+}
+
+bool Frustum::TestSphere(const glm::vec3& center, float radius) const
+{
+    for (const glm::vec4& p : planes)
+        if (glm::dot(glm::vec3(p), center) + p.w < -radius) return false;
+    return true;
+}
+
+FrustumTest Frustum::TestBox(const glm::vec3& min, const glm::vec3& max) const
+{
+    const glm::vec3 center = 0.5f * (min + max);
+    const glm::vec3 half = 0.5f * (max - min);
+
+    FrustumTest result = FrustumTest::Inside;
+    for (const glm::vec4& p : planes)
+    {
+        const float dist = glm::dot(glm::vec3(p), center) + p.w;
+        const float extent = glm::dot(glm::abs(glm::vec3(p)), half);
+
+        if (dist < -extent) return FrustumTest::Outside;
+        if (dist < extent) result = FrustumTest::Intersects;
+    }
+    return result;
+}
+
+// Signed distance minus the object's extent along the plane normal: negative = fully outside.
+// The extent is the smaller of the sphere radius and the box's projected half size.
+static bool ScalarVisible(const Frustum& f, const CullBounds& b, size_t i)
+{
+    for (const glm::vec4& p : f.planes)
+    {
+        const float dist = p.x * b.cx[i] + p.y * b.cy[i] + p.z * b.cz[i] + p.w;
+        const float box = std::abs(p.x) * b.ex[i] + std::abs(p.y) * b.ey[i] + std::abs(p.z) * b.ez[i];
+        if (dist + std::min(b.radius[i], box) < 0.0f) return false;
+    }
+    return true;
+}
+
+size_t CullBoundsAgainstFrustum(const Frustum& f, const CullBounds& b, size_t count, uint8_t* visible)
+{
+    size_t kept = 0;
+    size_t i = 0;
+
+#ifdef FRUSTUM_SSE
+    __m128 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+    for (int k = 0; k < 6; k++)
+    {
+        const glm::vec4& p = f.planes[k];
+        px[k] = _mm_set1_ps(p.x); ax[k] = _mm_set1_ps(std::abs(p.x));
+        py[k] = _mm_set1_ps(p.y); ay[k] = _mm_set1_ps(std::abs(p.y));
+        pz[k] = _mm_set1_ps(p.z); az[k] = _mm_set1_ps(std::abs(p.z));
+        pw[k] = _mm_set1_ps(p.w);
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+
+    // Four objects per iteration against all six planes
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 cx = _mm_loadu_ps(b.cx + i);
+        const __m128 cy = _mm_loadu_ps(b.cy + i);
+        const __m128 cz = _mm_loadu_ps(b.cz + i);
+        const __m128 r = _mm_loadu_ps(b.radius + i);
+        const __m128 ex = _mm_loadu_ps(b.ex + i);
+        const __m128 ey = _mm_loadu_ps(b.ey + i);
+        const __m128 ez = _mm_loadu_ps(b.ez + i);
+
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+        for (int k = 0; k < 6; k++)
+        {
+            __m128 dist = _mm_add_ps(_mm_mul_ps(px[k], cx), _mm_mul_ps(py[k], cy));
+            dist = _mm_add_ps(dist, _mm_add_ps(_mm_mul_ps(pz[k], cz), pw[k]));
+
+            __m128 box = _mm_add_ps(_mm_mul_ps(ax[k], ex), _mm_mul_ps(ay[k], ey));
+            box = _mm_add_ps(box, _mm_mul_ps(az[k], ez));
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, _mm_min_ps(r, box)), zero));
+        }
+
+        const int mask = _mm_movemask_ps(inside);
+        for (int l = 0; l < 4; l++)
+        {
+            visible[i + l] = (uint8_t)((mask >> l) & 1);
+            kept += visible[i + l];
+        }
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        visible[i] = ScalarVisible(f, b, i) ? 1 : 0;
+        kept += visible[i];
+    }
+
+    return kept;
+}
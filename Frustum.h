@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+enum class FrustumTest { Outside, Intersects, Inside };
+
+// Six normalized planes (xyz = inward normal, w = distance), extracted from proj * view
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    static Frustum FromMatrix(const glm::mat4& viewProj);
+
+    // The same frustum in the local space `model` maps to the world, for testing local bounds
+    Frustum Transformed(const glm::mat4& model) const;
+
+    FrustumTest TestBox(const glm::vec3& min, const glm::vec3& max) const;
+    bool TestSphere(const glm::vec3& center, float radius) const;     // false = fully outside
+};
+
+// World-space bounds for a batch of objects, one float per object in each array.
+// An object is kept if both its sphere (center, radius) and its box (center, halfExtent) touch the frustum.
+struct CullBounds
+{
+    const float* cx;
+    const float* cy;
+    const float* cz;
+    const float* radius;
+    const float* ex;
+    const float* ey;
+    const float* ez;
+};
+
+// Writes 1 (visible) or 0 (culled) per object; returns the visible count
+size_t CullBoundsAgainstFrustum(const Frustum& f, const CullBounds& b, size_t count, uint8_t* visible);
@@ -0,0 +1,51 @@
+#include "GlExtensions.h"
+#include <GLFW/glfw3.h>
+#include <cstring>
+
+static bool AtLeast(const GlExtensions& e, int major, int minor)
+{
+    return e.major > major || (e.major == major && e.minor >= minor);
+}
+
+static bool HasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (ext && std::strcmp(ext, name) == 0) return true;
+    }
+    return false;
+}
+
+static GlExtensions LoadGlExtensions()
+{
+    GlExtensions e;
+    glGetIntegerv(GL_MAJOR_VERSION, &e.major);
+    glGetIntegerv(GL_MINOR_VERSION, &e.minor);
+
+    if (AtLeast(e, 4, 3))
+    {
+        e.MultiDrawElementsIndirect = (PFNMULTIDRAWELEMENTSINDIRECT)glfwGetProcAddress("glMultiDrawElementsIndirect");
+        e.multiDrawIndirect = e.MultiDrawElementsIndirect != nullptr;
+
+        e.DispatchCompute = (PFNDISPATCHCOMPUTE)glfwGetProcAddress("glDispatchCompute");
+        e.ShaderMemoryBarrier = (PFNMEMORYBARRIER)glfwGetProcAddress("glMemoryBarrier");
+        e.computeShaders = e.DispatchCompute != nullptr && e.ShaderMemoryBarrier != nullptr;
+    }
+
+    if (AtLeast(e, 4, 4) || HasExtension("GL_ARB_buffer_storage"))
+    {
+        e.BufferStorage = (PFNBUFFERSTORAGE)glfwGetProcAddress("glBufferStorage");
+        e.bufferStorage = e.BufferStorage != nullptr;
+    }
+
+    return e;
+}
+
+const GlExtensions& GetGlExtensions()
+{
+    static const GlExtensions extensions = LoadGlExtensions();
+    return extensions;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// GL 4.3+ entry points and enums the GL 3.3 core loader does not cover. Resolved from the current
+// context on first use; callers check the flags and keep their GL 3.3 path when one is false.
+
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#endif
+#ifndef GL_COMMAND_BARRIER_BIT
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#endif
+#ifndef GL_BUFFER_UPDATE_BARRIER_BIT
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_SHADER_STORAGE_BARRIER_BIT
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+
+// Record layout fixed by GL for glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+    GLuint count = 0;
+    GLuint instanceCount = 0;
+    GLuint firstIndex = 0;
+    GLint baseVertex = 0;
+    GLuint baseInstance = 0;    // offsets every instanced attribute, so no re-pointing per draw
+};
+
+typedef void (APIENTRYP PFNMULTIDRAWELEMENTSINDIRECT)(GLenum mode, GLenum type, const void* indirect,
+    GLsizei drawcount, GLsizei stride);
+typedef void (APIENTRYP PFNBUFFERSTORAGE)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (APIENTRYP PFNDISPATCHCOMPUTE)(GLuint x, GLuint y, GLuint z);
+typedef void (APIENTRYP PFNMEMORYBARRIER)(GLbitfield barriers);
+
+struct GlExtensions
+{
+    int major = 0;
+    int minor = 0;
+
+    bool multiDrawIndirect = false;     // 4.3
+    PFNMULTIDRAWELEMENTSINDIRECT MultiDrawElementsIndirect = nullptr;
+
+    bool bufferStorage = false;         // 4.4 or ARB_buffer_storage
+    PFNBUFFERSTORAGE BufferStorage = nullptr;
+
+    bool computeShaders = false;        // 4.3, with shader storage buffers
+    PFNDISPATCHCOMPUTE DispatchCompute = nullptr;
+    PFNMEMORYBARRIER ShaderMemoryBarrier = nullptr;  // glMemoryBarrier (MemoryBarrier is a Windows macro)
+};
+
+// Needs a current context at the first call; one context per process
+const GlExtensions& GetGlExtensions();
@@ -0,0 +1,163 @@
+#include "GpuCuller.h"
+#include "shaderClass.h"
+#include <algorithm>
+#include <iostream>
+
+static constexpr GLuint kWorkGroupSize = 64;    // local_size_x in Cull.comp
+
+// Shader storage buffer holding `bytes` of data (at least 4 bytes, empty scenes still bind)
+static void UploadStorage(GLuint& buffer, const void* data, size_t bytes)
+{
+    if (buffer == 0)
+        glGenBuffers(1, &buffer);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)std::max<size_t>(bytes, 4), nullptr, GL_DYNAMIC_DRAW);
+    if (bytes > 0)
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)bytes, data);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+bool GpuCuller::Init()
+{
+    if (program != 0) return true;
+    if (initFailed) return false;
+    initFailed = true;
+
+    if (!GetGlExtensions().computeShaders || !GetGlExtensions().multiDrawIndirect)
+    {
+        std::cout << "GPU culling needs GL 4.3" << std::endl;
+        return false;
+    }
+
+    std::string code;
+    try
+    {
+        code = get_file_contents("Cull.comp");
+    }
+    catch (...)
+    {
+        std::cout << "GPU culling: cannot read Cull.comp" << std::endl;
+        return false;
+    }
+
+    const char* source = code.c_str();
+    const GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint ok = GL_FALSE;
+    char log[1024];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (ok == GL_FALSE)
+    {
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        std::cout << "SHADER_COMPILATION_ERROR for:COMPUTE\n" << log << std::endl;
+        glDeleteShader(shader);
+        return false;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, shader);
+    glLinkProgram(program);
+    glDeleteShader(shader);
+
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (ok == GL_FALSE)
+    {
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        std::cout << "SHADER_LINKING_ERROR for:COMPUTE\n" << log << std::endl;
+        glDeleteProgram(program);
+        program = 0;
+        return false;
+    }
+
+    stageLoc = glGetUniformLocation(program, "stage");
+    itemCountLoc = glGetUniformLocation(program, "itemCount");
+    timeLoc = glGetUniformLocation(program, "timeSec");
+    planesLoc = glGetUniformLocation(program, "planes");
+    initFailed = false;
+    return true;
+}
+
+size_t GpuCuller::SetScene(const std::vector<Object>& objects, const std::vector<GLuint>& groupBase,
+    size_t visibleSlots, const std::vector<DrawElementsIndirectCommand>& commands,
+    const std::vector<GLuint>& commandGroup)
+{
+    const size_t objectBytes = objects.size() * sizeof(Object);
+    const size_t commandBytes = commands.size() * sizeof(DrawElementsIndirectCommand);
+    const size_t commandGroupBytes = commandGroup.size() * sizeof(GLuint);
+
+    UploadStorage(objectBuffer, objects.data(), objectBytes);
+    UploadStorage(commandBuffer, commands.data(), commandBytes);
+    UploadStorage(commandGroupBuffer, commandGroup.data(), commandGroupBytes);
+    UploadStorage(visibleBuffer, nullptr, visibleSlots * sizeof(GLuint));
+
+    groupReset.resize(groupBase.size());
+    for (size_t g = 0; g < groupBase.size(); g++)
+        groupReset[g] = glm::uvec2(groupBase[g], 0u);
+    UploadStorage(groupBuffer, groupReset.data(), groupReset.size() * sizeof(glm::uvec2));
+
+    objectCount = objects.size();
+    commandCount = commands.size();
+    return objectBytes + commandBytes + commandGroupBytes + groupReset.size() * sizeof(glm::uvec2);
+}
+
+void GpuCuller::Cull(const Frustum& frustum, float timeSec, GLuint motionParams)
+{
+    const GlExtensions& ext = GetGlExtensions();
+
+    // Counts back to zero; the draws of the previous frame are ordered before this by GL
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, groupBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)(groupReset.size() * sizeof(glm::uvec2)), groupReset.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, motionParams);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, objectBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, groupBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, commandGroupBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, visibleBuffer);
+
+    glUseProgram(program);
+    glUniform1f(timeLoc, timeSec);
+    glUniform4fv(planesLoc, 6, &frustum.planes[0].x);
+
+    glUniform1ui(stageLoc, 0u);
+    glUniform1ui(itemCountLoc, (GLuint)objectCount);
+    if (objectCount > 0)
+        ext.DispatchCompute((GLuint)((objectCount + kWorkGroupSize - 1) / kWorkGroupSize), 1, 1);
+    ext.ShaderMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glUniform1ui(stageLoc, 1u);
+    glUniform1ui(itemCountLoc, (GLuint)commandCount);
+    if (commandCount > 0)
+        ext.DispatchCompute((GLuint)((commandCount + kWorkGroupSize - 1) / kWorkGroupSize), 1, 1);
+
+    // The draws read the commands as indirect records and the visible list as instance attributes
+    ext.ShaderMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+size_t GpuCuller::ReadVisibleCount()
+{
+    GetGlExtensions().ShaderMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    std::vector<glm::uvec2> groups(groupReset.size());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, groupBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)(groups.size() * sizeof(glm::uvec2)), groups.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    size_t visible = 0;
+    for (const glm::uvec2& g : groups) visible += g.y;
+    return visible;
+}
+
+void GpuCuller::Delete()
+{
+    if (program) glDeleteProgram(program);
+    GLuint buffers[] = { objectBuffer, groupBuffer, commandBuffer, commandGroupBuffer, visibleBuffer };
+    for (GLuint b : buffers)
+        if (b) glDeleteBuffers(1, &b);
+
+    *this = GpuCuller{};
+}
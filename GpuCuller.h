@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+#include "Frustum.h"
+#include "GlExtensions.h"
+
+// Frustum culling in a compute shader (Cull.comp) for scenes too large to cull on the CPU each
+// frame. Objects are grouped by draw state; every group owns a slice of the visible list sized for
+// all its objects and one indirect command per submesh whose baseInstance is that slice. Per frame
+// the group counts are reset, the visible objects appended to their slices and the counts copied
+// into the commands, which are then drawn as they are: nothing comes back to the CPU unless
+// ReadVisibleCount is called. Needs GL 4.3.
+class GpuCuller
+{
+public:
+    static constexpr GLuint kNoGroup = ~0u;
+
+    // Per object, in MeshSystem's objects order (std430 layout of CullObject)
+    struct Object
+    {
+        glm::vec4 center{ 0.0f };       // local bounds center, w = radius
+        glm::vec4 extent{ 0.0f };       // local half extent
+        glm::uvec4 info{ kNoGroup };    // x = draw group, kNoGroup = not drawn
+    };
+
+    // Compiles Cull.comp on first use; false without GL 4.3 or when it does not compile
+    bool Init();
+
+    // Uploads a new scene layout. groupBase[g] = first visible-list slot of group g, i.e. the prefix
+    // sum of the group sizes up to g; commandGroup[c] = group whose count command c draws.
+    // Returns the bytes uploaded.
+    size_t SetScene(const std::vector<Object>& objects, const std::vector<GLuint>& groupBase,
+        size_t visibleSlots, const std::vector<DrawElementsIndirectCommand>& commands,
+        const std::vector<GLuint>& commandGroup);
+
+    // Runs both stages. motionParams = MeshSystem's GPU motion buffer, 3 vec4 rows per object.
+    void Cull(const Frustum& frustum, float timeSec, GLuint motionParams);
+
+    // Debug: waits for the GPU and sums the visible counts of the last Cull
+    size_t ReadVisibleCount();
+
+    GLuint CommandBuffer() const { return commandBuffer; }
+    GLuint VisibleBuffer() const { return visibleBuffer; }
+    size_t ObjectCount() const { return objectCount; }
+    size_t CommandCount() const { return commandCount; }
+
+    void Delete();
+
+private:
+    GLuint program = 0;
+    GLint stageLoc = -1;
+    GLint itemCountLoc = -1;
+    GLint timeLoc = -1;
+    GLint planesLoc = -1;
+    bool initFailed = false;
+
+    GLuint objectBuffer = 0;
+    GLuint groupBuffer = 0;
+    GLuint commandBuffer = 0;
+    GLuint commandGroupBuffer = 0;
+    GLuint visibleBuffer = 0;
+
+    std::vector<glm::uvec2> groupReset;     // (base, 0) per group, uploaded before every cull
+    size_t objectCount = 0;
+    size_t commandCount = 0;
+};
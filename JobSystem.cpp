@@ -0,0 +1,140 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+JobSystem::JobSystem(unsigned int threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned int i = 0; i < threadCount; i++)
+        queues.push_back(std::make_unique<Queue>());
+
+    workers.reserve(threadCount - 1);
+    for (unsigned int i = 1; i < threadCount; i++)
+        workers.emplace_back([this, i]() { WorkerLoop(i); });
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lk(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& w : workers) w.join();
+}
+
+bool JobSystem::Pop(unsigned int self, Job& job)
+{
+    Queue& q = *queues[self];
+    std::lock_guard<std::mutex> lk(q.lock);
+    if (q.jobs.empty()) return false;
+
+    job = q.jobs.back();
+    q.jobs.pop_back();
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+// Victims are tried round-robin starting after self; the front holds the oldest, largest-index work
+bool JobSystem::Steal(unsigned int self, Job& job)
+{
+    const unsigned int n = ThreadCount();
+    for (unsigned int k = 1; k < n; k++)
+    {
+        Queue& q = *queues[(self + k) % n];
+        std::lock_guard<std::mutex> lk(q.lock);
+        if (q.jobs.empty()) continue;
+
+        job = q.jobs.front();
+        q.jobs.pop_front();
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::Run(const Job& job)
+{
+    (*job.fn)(job.begin, job.end);
+
+    // Only members are touched after the last decrement: the counter dies with ParallelFor's frame
+    if (job.pending->fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        std::lock_guard<std::mutex> lk(doneLock);
+        done.notify_all();
+    }
+}
+
+void JobSystem::WorkerLoop(unsigned int self)
+{
+    for (;;)
+    {
+        Job job;
+        if (Pop(self, job) || Steal(self, job))
+        {
+            Run(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lk(sleepLock);
+        wake.wait(lk, [this]() { return stopping || queued.load(std::memory_order_relaxed) > 0; });
+        if (stopping) return;
+    }
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain, const RangeFn& fn)
+{
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+
+    const size_t jobCount = (count + grain - 1) / grain;
+    if (jobCount == 1 || ThreadCount() == 1)
+    {
+        fn(0, count);
+        return;
+    }
+
+    std::atomic<size_t> pending{ jobCount };
+
+    // Contiguous runs of ranges per deque, so each thread starts on its own slice of the data
+    const unsigned int n = ThreadCount();
+    for (unsigned int t = 0; t < n; t++)
+    {
+        const size_t first = jobCount * t / n;
+        const size_t last = jobCount * (t + 1) / n;
+
+        Queue& q = *queues[t];
+        std::lock_guard<std::mutex> lk(q.lock);
+        for (size_t j = last; j-- > first; )   // back = first range, popped first by the owner
+            q.jobs.push_back(Job{ &fn, j * grain, std::min(count, (j + 1) * grain), &pending });
+
+        // Published under the deque lock once the jobs are in it, so a woken worker always finds them
+        queued.fetch_add(last - first, std::memory_order_relaxed);
+    }
+
+    // A worker between its empty check and its wait holds sleepLock: taking it first means the
+    // notify cannot fall into that gap
+    {
+        std::lock_guard<std::mutex> lk(sleepLock);
+    }
+    wake.notify_all();
+
+    // Help until every deque is empty; the remaining jobs are then running elsewhere
+    Job job;
+    while (Pop(0, job) || Steal(0, job))
+        Run(job);
+
+    std::unique_lock<std::mutex> lk(doneLock);
+    done.wait(lk, [&pending]() { return pending.load(std::memory_order_acquire) == 0; });
+}
+
+void ParallelFor(JobSystem* jobs, size_t count, size_t grain, const JobSystem::RangeFn& fn)
+{
+    if (!jobs || count <= grain)
+    {
+        if (count > 0) fn(0, count);
+        return;
+    }
+    jobs->ParallelFor(count, grain, fn);
+}
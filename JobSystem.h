@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads with one job deque each. Owners pop from the back of their own
+// deque, idle threads steal from the front of the others'. The calling thread joins in too,
+// so JobSystem(1) runs everything inline.
+class JobSystem
+{
+public:
+    using RangeFn = std::function<void(size_t begin, size_t end)>;
+
+    explicit JobSystem(unsigned int threadCount = 0);   // 0 = hardware threads; counts the caller
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned int ThreadCount() const { return (unsigned int)queues.size(); }
+
+    // Runs fn over [0, count) in ranges of `grain` items and returns once all are done.
+    // One calling thread at a time (it uses deque 0); fn must not call ParallelFor itself.
+    void ParallelFor(size_t count, size_t grain, const RangeFn& fn);
+
+private:
+    struct Job
+    {
+        const RangeFn* fn = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+        std::atomic<size_t>* pending = nullptr;
+    };
+
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<Job> jobs;
+    };
+
+    bool Pop(unsigned int self, Job& job);
+    bool Steal(unsigned int self, Job& job);
+    void Run(const Job& job);
+    void WorkerLoop(unsigned int self);
+
+    std::vector<std::unique_ptr<Queue>> queues;     // [0] = the thread calling ParallelFor
+    std::vector<std::thread> workers;
+
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::atomic<size_t> queued{ 0 };                // jobs sitting in any deque, counted under its lock
+    bool stopping = false;
+
+    // The caller of ParallelFor sleeps here once no job is left to take, until the last one finishes
+    std::mutex doneLock;
+    std::condition_variable done;
+};
+
+// fn(0, count) inline without a job system or below one grain of work
+void ParallelFor(JobSystem* jobs, size_t count, size_t grain, const JobSystem::RangeFn& fn);
@@ -1,7 +1,11 @@
 #include "Main.h"
 #include "ObjectLoader.h"
-#include <algorithm>
+#include "MeshCache.h"
+#include "Benchmark.h"
+#include "SimulationThread.h"
+#include <chrono>
 #include <cmath>
+#include <cstring>
 
 static constexpr unsigned int kWindowW = 800;
 static constexpr unsigned int kWindowH = 800;
@@ -20,33 +24,6 @@ static constexpr float kLightStep = 1.0f;
 static constexpr float kLightLimit = 5.0f;
 
 
-// Ray vs AABB (slab method)
-static bool RayAABB(const glm::vec3& rayOrigin,
-    const glm::vec3& rayDirection,
-    const glm::vec3& boxCenter,
-    const glm::vec3& boxHalfSize,
-    float& hitDistance)
-{
-    const glm::vec3 invDir = 1.0f / rayDirection;
-    const glm::vec3 boxMin = boxCenter - boxHalfSize;
-    const glm::vec3 boxMax = boxCenter + boxHalfSize;
-
-    const glm::vec3 tNear = (boxMin - rayOrigin) * invDir;
-    const glm::vec3 tFar = (boxMax - rayOrigin) * invDir;
-
-    const glm::vec3 tMin = glm::min(tNear, tFar);
-    const glm::vec3 tMax = glm::max(tNear, tFar);
-
-    const float entryDistance = std::max({ tMin.x, tMin.y, tMin.z });
-    const float exitDistance = std::min({ tMax.x, tMax.y, tMax.z });
-
-    if (exitDistance < 0.0f || entryDistance > exitDistance)
-        return false;
-
-    hitDistance = (entryDistance >= 0.0f) ? entryDistance : exitDistance;
-    return true;
-}
-
 static glm::vec3 MouseRayDirection(GLFWwindow* window,
     const Camera& camera,
     int screenWidth,
@@ -67,23 +44,6 @@ static glm::vec3 MouseRayDirection(GLFWwindow* window,
     return glm::normalize(glm::vec3(glm::inverse(view) * rayEye));
 }
 
-static bool IsObjectHitByMouse(GLFWwindow* window,
-    const Camera& camera,
-    MeshSystem& mesh,
-    const char* objectName,
-    int screenWidth,
-    int screenHeight)
-{
-    SceneObject* object = mesh.FindObject(objectName);
-    if (!object) return false;
-
-    const glm::vec3 rayOrigin = camera.Position;
-    const glm::vec3 rayDir = MouseRayDirection(window, camera, screenWidth, screenHeight);
-
-    float hitDistance = 0.0f;
-    return RayAABB(rayOrigin, rayDir, object->pos, 0.5f * object->scale, hitDistance);
-}
-
 static inline float WrapStep(float v, float step, float limit)
 {
     v += step;
@@ -95,11 +55,19 @@ static inline float WrapStep(float v, float step, float limit)
 GLFWwindow* InitWindow(unsigned int w, unsigned int h, const char* title)
 {
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    GLFWwindow* window = glfwCreateWindow(w, h, title, NULL, NULL);
+    // 4.3 allows MeshSystem's indirect draw path; 3.3 is all the rest needs
+    GLFWwindow* window = nullptr;
+    static const int kVersions[][2] = { { 4, 3 }, { 3, 3 } };
+    for (const auto& v : kVersions)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, v[0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, v[1]);
+        window = glfwCreateWindow(w, h, title, NULL, NULL);
+        if (window) break;
+    }
+
     if (!window)
     {
         glfwTerminate();
@@ -140,34 +108,54 @@ void SpawnDefaultObjects(MeshSystem& mesh)
     mesh.AddObjectInstance({ "Cube1",     "cube",     "brick", "default", {3.0f,0,0},  {0.7f,0.7f,0.7f},    Motion::RotateXY, 90.0f });
 }
 
-static void SpawnImportedObject(MeshSystem& mesh)
+static void SpawnImportedObject(MeshSystem& mesh, JobSystem& jobs)
 {
-    CpuMeshData imported = ObjectLoader::LoadOBJ("models/Testing1.obj");
-    mesh.AddMesh("testing", imported);
+    const std::string path = "models/Testing1.obj";
+
+    // Cache hit: upload straight from the mapped blob, no text parsing or simplification
+    MeshCache cache;
+    if (cache.Open(path))
+    {
+        mesh.AddMesh("testing", cache.Vertices(), cache.VertexFloatCount(), cache.Indices(), cache.IndexCount(),
+            cache.Materials(), cache.Submeshes(), cache.Lods(), cache.Meshlets());
+    }
+    else
+    {
+        mesh.AddMesh("testing", ObjectLoader::ImportOBJ(path, &jobs));
+    }
+
     mesh.AddObjectInstance({ "Testing1", "testing", "brick", "default", {0,0,10.0f}, {1,1,1}, Motion::RotateXY, 90.0f });
 }
 
-static void SpawnLamp(MeshSystem& mesh, const glm::vec3& lightPos)
+static ObjectHandle SpawnLamp(MeshSystem& mesh, const glm::vec3& lightPos)
 {
-    mesh.AddObjectInstance({ "Lamp", "cube", "brick", "object", lightPos, {0.2f,0.2f,0.2f}, Motion::None, 0.0f });
+    return mesh.AddObjectInstance({ "Lamp", "cube", "brick", "object", lightPos, {0.2f,0.2f,0.2f}, Motion::None, 0.0f });
 }
 
-static void SpawnUiButtons(MeshSystem& mesh)
+struct UiButtons
+{
+    ObjectHandle left;
+    ObjectHandle right;
+};
+
+static UiButtons SpawnUiButtons(MeshSystem& mesh)
 {
-    mesh.AddObjectInstance({ "BtnLeft",  "cube", "anime", "default", {0,0,0}, {0.18f,0.18f,0.18f}, Motion::None, 0.0f });
-    mesh.AddObjectInstance({ "BtnRight", "cube", "anime", "default", {0,0,0}, {0.18f,0.18f,0.18f}, Motion::None, 0.0f });
+    UiButtons ui;
+    ui.left = mesh.AddObjectInstance({ "BtnLeft",  "cube", "anime", "default", {0,0,0}, {0.18f,0.18f,0.18f}, Motion::None, 0.0f });
+    ui.right = mesh.AddObjectInstance({ "BtnRight", "cube", "anime", "default", {0,0,0}, {0.18f,0.18f,0.18f}, Motion::None, 0.0f });
+    return ui;
 }
 
-static void UpdateUiButtonPositions(MeshSystem& mesh, const Camera& camera)
+static void UpdateUiButtonPositions(MeshSystem& mesh, const Camera& camera, const UiButtons& ui)
 {
     const glm::vec3 forward = glm::normalize(camera.Orientation);
     const glm::vec3 right = glm::normalize(glm::cross(forward, camera.Up));
     const glm::vec3 up = glm::normalize(camera.Up);
 
-    if (SceneObject* bL = mesh.FindObject("BtnLeft"))
+    if (SceneObject* bL = mesh.GetObject(ui.left))
         bL->pos = camera.Position + forward * kUiDist - right * kUiSide + up * kUiDown;
 
-    if (SceneObject* bR = mesh.FindObject("BtnRight"))
+    if (SceneObject* bR = mesh.GetObject(ui.right))
         bR->pos = camera.Position + forward * kUiDist + right * kUiSide + up * kUiDown;
 }
 
@@ -181,8 +169,11 @@ static bool ConsumeRmbEdge(GLFWwindow* window, bool& wasRmbDown)
 
 // ------------------------ Main ------------------------
 
-int main()
+int main(int argc, char** argv)
 {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+        return bench::Run(argc - 2, argv + 2);
+
     GLFWwindow* window = InitWindow(kWindowW, kWindowH, "TestOpenGL");
     if (!window) return -1;
 
@@ -190,7 +181,14 @@ int main()
     Shader objectShader("Object.vert", "Object.frag");
     Camera camera(kWindowW, kWindowH, glm::vec3(0, 0, 2));
 
+    JobSystem jobs;
     MeshSystem mesh;
+    mesh.SetJobSystem(&jobs);
+
+    // The lamp's shader reads only positions: keep a tight copy of them next to the full vertices
+    VertexLayout layout = VertexLayout::Full();
+    layout.positionStream = true;
+    mesh.SetVertexLayout(layout);
     RegisterDefaultMeshes(mesh);
     RegisterDefaultTextures(mesh, defaultShader);
     SpawnDefaultObjects(mesh);
@@ -198,45 +196,76 @@ int main()
     mesh.RegisterShaderProgram("default", defaultShader);
     mesh.RegisterShaderProgram("object", objectShader);
 
-    SpawnImportedObject(mesh);
+    SpawnImportedObject(mesh, jobs);
 
     glm::vec4 lightColor(1, 1, 1, 1);
     glm::vec3 lightPos(0.5f, 0.5f, 0.5f);
     mesh.SetLightParams(lightColor, lightPos);
 
-    SpawnLamp(mesh, lightPos);
-    SpawnUiButtons(mesh);
+    const ObjectHandle lamp = SpawnLamp(mesh, lightPos);
+    const UiButtons ui = SpawnUiButtons(mesh);
+
+    // From here on the scene belongs to the update stage: UI, picking, light and the CPU half
+    // of rendering run on the simulation thread, this thread samples input and submits snapshots
+    uint32_t handledPick = 0;
+
+    SimulationThread sim;
+    sim.Start([&](const InputSample& in, SceneSnapshot& out)
+    {
+        UpdateUiButtonPositions(mesh, in.camera, ui);
+
+        // Nearest button under the cursor, found through the scene BVH; other objects never block a click
+        if (in.pickSerial != handledPick)
+        {
+            handledPick = in.pickSerial;
+            const ObjectHandle hit = mesh.Raycast(in.pickOrigin, in.pickDir, in.timeSec, { ui.left, ui.right });
+
+            if (hit == ui.left)
+                lightPos.x = WrapStep(lightPos.x, -kLightStep, kLightLimit);
+
+            if (hit == ui.right)
+                lightPos.x = WrapStep(lightPos.x, kLightStep, kLightLimit);
+        }
+
+        mesh.SetLightParams(lightColor, lightPos);
+        if (SceneObject* lampObject = mesh.GetObject(lamp))
+            lampObject->pos = lightPos;
+
+        mesh.Prepare(out.render, in.camera, in.timeSec);
+        out.inputSampledAt = in.sampledAt;
+    });
 
+    InputSample input;
     bool wasRmbDown = false;
 
     while (!glfwWindowShouldClose(window))
     {
-        glClearColor(0.07f, 0.13f, 0.17f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
         camera.Inputs(window);
 
-        UpdateUiButtonPositions(mesh, camera);
+        input.camera = camera;
+        input.timeSec = (float)glfwGetTime();
+        input.sampledAt = std::chrono::steady_clock::now();
 
         if (ConsumeRmbEdge(window, wasRmbDown))
         {
-            if (IsObjectHitByMouse(window, camera, mesh, "BtnLeft", int(kWindowW), int(kWindowH)))
-                lightPos.x = WrapStep(lightPos.x, -kLightStep, kLightLimit);
-
-            if (IsObjectHitByMouse(window, camera, mesh, "BtnRight", int(kWindowW), int(kWindowH)))
-                lightPos.x = WrapStep(lightPos.x, kLightStep, kLightLimit);
+            input.pickSerial++;
+            input.pickOrigin = camera.Position;
+            input.pickDir = MouseRayDirection(window, camera, int(kWindowW), int(kWindowH));
         }
 
-        mesh.SetLightParams(lightColor, lightPos);
-        if (SceneObject* lamp = mesh.FindObject("Lamp"))
-            lamp->pos = lightPos;
+        sim.PublishInput(input);
+
+        glClearColor(0.07f, 0.13f, 0.17f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        mesh.Render(camera, (float)glfwGetTime());
+        if (const SceneSnapshot* frame = sim.LatestSnapshot())
+            mesh.Submit(frame->render);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    sim.Stop();
     mesh.Shutdown();
     defaultShader.Delete();
     objectShader.Delete();
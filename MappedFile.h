@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file mapped into the address space
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    const char* Data() const { return data; }
+    size_t Size() const { return size; }
+    bool IsOpen() const { return isOpen; }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    bool isOpen = false;
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
@@ -1,59 +1,353 @@
 #include "Mesh.h"
+#include "MeshletBuilder.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <cmath>
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include <limits>
 
-static constexpr int VERTEX_STRIDE_FLOATS = 11; // pos3 + color3 + uv2 + normal3
+static constexpr int VERTEX_STRIDE_FLOATS = (int)VertexLayout::kSourceFloats;
+static constexpr GLuint VERTEX_COLOR_LOCATION = 1;    // generic value when a mesh has no color stream
+static constexpr GLuint INSTANCE_MATRIX_LOCATION = 4; // mat4 = locations 4..7
+static constexpr GLuint INSTANCE_OBJECT_LOCATION = 8; // uint object index, GPU motion
+static constexpr GLuint FRAME_UNIFORM_BINDING = 0;  // uniform block binding of FrameData
+static constexpr size_t INSTANCE_ALIGNMENT = 16;    // of instance data in the stream ring
+static constexpr GLuint MOTION_TEXTURE_UNIT = 1;    // samplerBuffer motionParams
+static constexpr size_t MOTION_TEXELS = 3;          // RGBA32F texels per object, see PackMotionParams
+static constexpr float CAMERA_FOV_DEG = 45.0f;
+static constexpr float CAMERA_NEAR = 0.1f;
+static constexpr float CAMERA_FAR = 50.0f;
+static constexpr float BVH_REBUILD_AREA_RATIO = 2.0f;  // root growth from refits that triggers a rebuild
+static constexpr size_t JOB_GRAIN_OBJECTS = 4096;   // objects per job for bounds, culling and draw keys
+static constexpr size_t JOB_GRAIN_MATRICES = 2048;  // model matrices per job
 
-void MeshSystem::LinkVertexLayout(GpuMesh& m)
+// Draw sort key, high to low: shader slot | texture + 1 (0 = none) | mesh | LOD | view depth.
+// Sorting groups state changes by cost; depth orders each group front to back.
+static constexpr int KEY_DEPTH_BITS = 21;
+static constexpr int KEY_LOD_BITS = 3;
+static constexpr int KEY_MESH_BITS = 16;
+static constexpr int KEY_TEXTURE_BITS = 12;
+static constexpr int KEY_SHADER_BITS = 12;
+static constexpr int KEY_LOD_SHIFT = KEY_DEPTH_BITS;
+static constexpr int KEY_MESH_SHIFT = KEY_LOD_SHIFT + KEY_LOD_BITS;
+static constexpr int KEY_TEXTURE_SHIFT = KEY_MESH_SHIFT + KEY_MESH_BITS;
+static constexpr int KEY_SHADER_SHIFT = KEY_TEXTURE_SHIFT + KEY_TEXTURE_BITS;
+static_assert(KEY_SHADER_SHIFT + KEY_SHADER_BITS == 64, "draw key must fill 64 bits");
+
+static constexpr size_t MAX_KEY_MESHES = size_t(1) << KEY_MESH_BITS;
+static constexpr size_t MAX_KEY_TEXTURES = (size_t(1) << KEY_TEXTURE_BITS) - 1;
+static constexpr size_t MAX_KEY_SHADERS = size_t(1) << KEY_SHADER_BITS;
+static constexpr size_t MAX_KEY_LODS = size_t(1) << KEY_LOD_BITS;   // full detail + 7 coarser levels
+static constexpr uint64_t NO_CULL_KEY = ~uint64_t(0);  // never a real key: its depth bits are zero
+
+static uint64_t MakeDrawKey(unsigned int shader, int texture, unsigned int mesh, unsigned int lod, float depth)
+{
+    const float maxDepth = float((1u << KEY_DEPTH_BITS) - 1);
+    const float d = std::clamp(depth / CAMERA_FAR, 0.0f, 1.0f) * maxDepth;
+
+    return (uint64_t(shader) << KEY_SHADER_SHIFT)
+        | (uint64_t(texture + 1) << KEY_TEXTURE_SHIFT)
+        | (uint64_t(mesh) << KEY_MESH_SHIFT)
+        | (uint64_t(lod) << KEY_LOD_SHIFT)
+        | uint64_t(d);
+}
+
+static unsigned int KeyShader(uint64_t key) { return unsigned(key >> KEY_SHADER_SHIFT); }
+static int KeyTexture(uint64_t key) { return int((key >> KEY_TEXTURE_SHIFT) & ((1u << KEY_TEXTURE_BITS) - 1)) - 1; }
+static unsigned int KeyMesh(uint64_t key) { return unsigned((key >> KEY_MESH_SHIFT) & ((1u << KEY_MESH_BITS) - 1)); }
+static unsigned int KeyLod(uint64_t key) { return unsigned((key >> KEY_LOD_SHIFT) & ((1u << KEY_LOD_BITS) - 1)); }
+
+// Same shader, texture, mesh and LOD: can share one instanced draw
+static bool SameState(uint64_t a, uint64_t b)
+{
+    return (a >> KEY_LOD_SHIFT) == (b >> KEY_LOD_SHIFT);
+}
+
+static const std::vector<GpuSubMesh>& LodSubmeshes(const GpuMesh& m, unsigned int lod)
+{
+    return lod == 0 ? m.submeshes : m.lods[lod - 1].submeshes;
+}
+
+// AABB over the positions, then the smallest sphere around its center that holds every vertex
+static void ComputeBounds(GpuMesh& m, const float* vertices, size_t vertexFloatCount)
+{
+    const size_t count = vertexFloatCount / VERTEX_STRIDE_FLOATS;
+    if (count == 0) return;
+
+    glm::vec3 lo(vertices[0], vertices[1], vertices[2]);
+    glm::vec3 hi = lo;
+    for (size_t i = 1; i < count; i++)
+    {
+        const float* v = vertices + i * VERTEX_STRIDE_FLOATS;
+        const glm::vec3 p(v[0], v[1], v[2]);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+
+    m.boundsCenter = 0.5f * (lo + hi);
+    m.boundsHalfExtent = 0.5f * (hi - lo);
+
+    float r2 = 0.0f;
+    for (size_t i = 0; i < count; i++)
+    {
+        const float* v = vertices + i * VERTEX_STRIDE_FLOATS;
+        const glm::vec3 d = glm::vec3(v[0], v[1], v[2]) - m.boundsCenter;
+        r2 = std::max(r2, glm::dot(d, d));
+    }
+    m.boundsRadius = std::sqrt(r2);
+}
+
+// Interns `id` and grows its resolution table (-1 = not registered yet) to cover it
+static uint32_t InternId(StringInterner& ids, std::vector<int>& table, const std::string& id)
+{
+    const uint32_t i = ids.Intern(id);
+    if (table.size() <= i) table.resize((size_t)i + 1, -1);
+    return i;
+}
+
+static bool IsRotating(Motion m)
+{
+    return m == Motion::RotateX || m == Motion::RotateY || m == Motion::RotateXY;
+}
+
+// Row of the GPU motion buffer, read by ModelMatrix() in VertexCommon.glsl and by Cull.comp:
+// (position or bob base, Motion), (scale, rad/s or bob frequency), (bob amplitude, unused)
+static void PackMotionParams(const SceneObject& o, glm::vec4* out)
+{
+    const bool bob = o.motion == Motion::BobY;
+    out[0] = glm::vec4(bob ? o.basePos : o.pos, float(o.motion));
+    out[1] = glm::vec4(o.scale, bob ? o.bobFreq : glm::radians(o.rotSpeedDeg));
+    out[2] = glm::vec4(o.bobAmp, 0.0f, 0.0f, 0.0f);
+}
+
+// Arena holding the meshes stored in `layout`, created on first use
+unsigned int MeshSystem::ArenaFor(const VertexLayout& layout)
+{
+    for (size_t i = 0; i < arenas.size(); i++)
+        if (arenas[i].arena.Layout().SameFormat(layout)) return (unsigned int)i;
+
+    LayoutArena& a = arenas.emplace_back();
+    a.arena = MeshArena(layout);
+    return (unsigned int)arenas.size() - 1;
+}
+
+// Instance attributes of an arena's VAOs, set up once; SetInstanceLayout picks which are enabled.
+// Their buffer and offsets come every frame from PointInstanceAttributes.
+void MeshSystem::LinkInstanceLayout(LayoutArena& a)
 {
-    m.vao.Bind();
-    m.vbo.Bind();
-    m.ebo.Bind();
+    for (GLuint vao : { a.arena.Vao(), a.arena.PositionVao() })
+    {
+        if (vao == 0) continue;
+        glBindVertexArray(vao);
 
-    const GLsizei stride = VERTEX_STRIDE_FLOATS * sizeof(float);
+        // Instance matrix, one column per location
+        for (GLuint c = 0; c < 4; c++)
+        {
+            glEnableVertexAttribArray(INSTANCE_MATRIX_LOCATION + c);
+            glVertexAttribDivisor(INSTANCE_MATRIX_LOCATION + c, 1);
+        }
 
-    m.vao.LinkAttrib(m.vbo, 0, 3, GL_FLOAT, stride, (void*)0);                         // pos
-    m.vao.LinkAttrib(m.vbo, 1, 3, GL_FLOAT, stride, (void*)(3 * sizeof(float)));       // color
-    m.vao.LinkAttrib(m.vbo, 2, 2, GL_FLOAT, stride, (void*)(6 * sizeof(float)));       // uv
-    m.vao.LinkAttrib(m.vbo, 3, 3, GL_FLOAT, stride, (void*)(8 * sizeof(float)));       // normal
+        // Object index for GPU motion, enabled instead of the matrix by SetInstanceLayout
+        glVertexAttribDivisor(INSTANCE_OBJECT_LOCATION, 1);
+    }
 
-    m.vao.Unbind();
-    m.vbo.Unbind();
-    m.ebo.Unbind();
+    glBindVertexArray(0);
+    a.objectInstances[0] = a.objectInstances[1] = false;
+    a.instancesLinked = true;
 }
 
 void MeshSystem::AddMesh(const std::string& id, const CpuMeshData& data)
 {
-    if (meshById.count(id)) return;
+    AddMesh(id, data.vertices.data(), data.vertices.size(), data.indices.data(), data.indices.size(),
+        data.materials, data.submeshes, data.lods, data.meshlets);
+}
+
+void MeshSystem::AddMesh(const std::string& id, const float* vertices, size_t vertexFloatCount,
+    const GLuint* indices, size_t indexCount,
+    const std::vector<MeshMaterial>& materials, const std::vector<SubMesh>& submeshes,
+    const std::vector<MeshLod>& lods, const std::vector<Meshlet>& meshlets)
+{
+    const uint32_t meshId = InternId(meshIds, meshOfId, id);
+    if (meshOfId[meshId] >= 0) return;
+
+    if (meshes.size() >= MAX_KEY_MESHES)
+    {
+        std::cout << "Too many meshes, skipping: " << id << std::endl;
+        return;
+    }
+
+    GpuMesh& m = meshes.emplace_back();
+    ComputeBounds(m, vertices, vertexFloatCount);
+
+    // Quantized positions are relative to the bounds, so those come first
+    const size_t vertexCount = vertexFloatCount / VERTEX_STRIDE_FLOATS;
+    const VertexLayout layout = vertexLayout.ForMesh(vertices, vertexCount, m.vertexState.constantColor);
+    m.vertexState.colorStream = layout.color != ColorFormat::None;
+    m.vertexState.decode = layout.Decode(m.boundsCenter, m.boundsHalfExtent);
+
+    // The full layout is the source vertex as is
+    std::vector<uint8_t> packed, positions;
+    VertexLayout interleaved = layout;
+    interleaved.positionStream = false;
+    if (!interleaved.SameFormat(VertexLayout::Full()))
+        packed = layout.Pack(vertices, vertexCount, m.boundsCenter, m.boundsHalfExtent);
+    if (layout.positionStream)
+        positions = layout.PackPositions(vertices, vertexCount, m.boundsCenter, m.boundsHalfExtent);
+
+    m.arena = ArenaFor(layout);
+    LayoutArena& a = arenas[m.arena];
+    const MeshArena::Range range = a.arena.Add(packed.empty() ? (const void*)vertices : packed.data(),
+        positions.data(), vertexCount, indices, indexCount);
+    if (!a.instancesLinked)
+        LinkInstanceLayout(a);
+
+    meshOfId[meshId] = (int)meshes.size() - 1;
+    bvhDirty = true;
+    gpuCullDirty = true;
+
+    m.baseVertex = range.baseVertex;
+    m.firstIndex = range.firstIndex;
+    m.indexCount = (GLsizei)indexCount;
+    m.vertexCount = (GLsizei)vertexCount;
+    m.vertexStride = layout.Stride();
+    m.positionStride = layout.positionStream ? layout.PositionStride() : 0;
+    m.meshlets = meshlets;
+    hasMeshlets = hasMeshlets || !meshlets.empty();
+
+    if (submeshes.empty())
+    {
+        m.submeshes.push_back(GpuSubMesh{ 0, (GLsizei)indexCount });
+        return;
+    }
+
+    auto resolve = [&](const std::vector<SubMesh>& ranges, std::vector<GpuSubMesh>& dst)
+    {
+        for (const SubMesh& s : ranges)
+        {
+            GpuSubMesh g;
+            g.indexOffset = s.indexOffset;
+            g.indexCount = s.indexCount;
+
+            if (s.material < materials.size())
+            {
+                const MeshMaterial& mat = materials[s.material];
+                g.diffuse = mat.diffuse;
+
+                // Material textures are keyed by their path; missing files keep the object's texture
+                if (!mat.diffuseMap.empty() && std::filesystem::exists(mat.diffuseMap))
+                {
+                    AddTexture(mat.diffuseMap, mat.diffuseMap);
+                    g.texture = textureOfId[textureIds.Find(mat.diffuseMap)];
+                }
+            }
 
-    meshes.emplace_back(
-        data.vertices.data(), (GLsizeiptr)(data.vertices.size() * sizeof(float)),
-        data.indices.data(), (GLsizeiptr)(data.indices.size() * sizeof(GLuint)),
-        (GLsizei)data.indices.size()
-    );
+            dst.push_back(g);
+        }
+    };
+
+    resolve(submeshes, m.submeshes);
 
-    LinkVertexLayout(meshes.back());
-    meshById.emplace(id, meshes.size() - 1);
+    // Levels past what the draw key holds are dropped
+    for (size_t i = 0; i < lods.size() && i + 1 < MAX_KEY_LODS; i++)
+    {
+        GpuMeshLod& lod = m.lods.emplace_back();
+        lod.error = lods[i].error;
+        resolve(lods[i].submeshes, lod.submeshes);
+    }
 }
 
 void MeshSystem::AddPrimitiveMesh(const std::string& id, gfx::ShapeType type)
 {
     auto m = gfx::Shapes::Get(type);
-    AddMesh(id, CpuMeshData{ m.vertices, m.indices });
+
+    CpuMeshData data;
+    data.vertices = std::move(m.vertices);
+    data.indices = std::move(m.indices);
+    AddMesh(id, data);
+}
+
+std::vector<MeshMemoryStats> MeshSystem::GetMeshMemory() const
+{
+    const size_t fullStride = VertexLayout::Full().Stride();
+    std::vector<MeshMemoryStats> out;
+
+    for (size_t id = 0; id < meshOfId.size(); id++)
+    {
+        if (meshOfId[id] < 0) continue;
+
+        const GpuMesh& m = meshes[meshOfId[id]];
+        MeshMemoryStats s;
+        s.id = meshIds.Name((uint32_t)id);
+        s.vertices = (size_t)m.vertexCount;
+        s.indices = (size_t)m.indexCount;
+        s.vertexStride = m.vertexStride;
+        s.positionStride = m.positionStride;
+        s.bytes = s.vertices * (m.vertexStride + m.positionStride) + s.indices * sizeof(GLuint);
+        s.fullBytes = s.vertices * fullStride + s.indices * sizeof(GLuint);
+        out.push_back(s);
+    }
+    return out;
 }
 
 void MeshSystem::AddTexture(const std::string& id, const std::string& filePath, GLenum format)
 {
-    if (textureById.count(id)) return;
+    const uint32_t textureId = InternId(textureIds, textureOfId, id);
+    if (textureOfId[textureId] >= 0) return;
+
+    if (textures.size() >= MAX_KEY_TEXTURES)
+    {
+        std::cout << "Too many textures, skipping: " << id << std::endl;
+        return;
+    }
 
     textures.emplace_back(filePath.c_str(), GL_TEXTURE_2D, GL_TEXTURE0, format, GL_UNSIGNED_BYTE);
-    textureById.emplace(id, textures.size() - 1);
+    textureOfId[textureId] = (int)textures.size() - 1;
+    gpuCullDirty = true;
 }
 
 void MeshSystem::RegisterShaderProgram(const std::string& id, Shader& shader)
 {
-    shaderById[id] = &shader;
+    const uint32_t shaderId = InternId(shaderIds, shaderOfId, id);
+    unsigned int slot;
+
+    if (shaderOfId[shaderId] >= 0)
+        slot = (unsigned int)shaderOfId[shaderId];
+    else
+    {
+        if (shaderSlots.size() >= MAX_KEY_SHADERS)
+        {
+            std::cout << "Too many shader programs, skipping: " << id << std::endl;
+            return;
+        }
+
+        slot = (unsigned int)shaderSlots.size();
+        shaderOfId[shaderId] = (int)slot;
+        shaderSlots.push_back(nullptr);
+        uniformsBySlot.emplace_back();
+        decodeBySlot.emplace_back();
+    }
+
+    shaderSlots[slot] = &shader;
+    uniformsBySlot[slot] = GetShaderUniforms(shader);
+    decodeBySlot[slot] = VertexDecode{};
+    gpuCullDirty = true;
+
+    // Program state persists, so the block binding, sampler units and identity decode are set once here
+    const GLuint block = glGetUniformBlockIndex(shader.ID, "FrameData");
+    if (block != GL_INVALID_INDEX)
+        glUniformBlockBinding(shader.ID, block, FRAME_UNIFORM_BINDING);
+
+    const ShaderUniforms& u = uniformsBySlot[slot];
+    const GLint motionParams = glGetUniformLocation(shader.ID, "motionParams");
+    if (u.tex0 != -1 || motionParams != -1 || u.vertexDecode != -1)
+    {
+        shader.Activate();
+        if (u.tex0 != -1) glUniform1i(u.tex0, 0);
+        if (motionParams != -1) glUniform1i(motionParams, MOTION_TEXTURE_UNIT);
+        if (u.vertexDecode != -1) glUniform4fv(u.vertexDecode, 2, &decodeBySlot[slot].scale.x);
+    }
 }
 
 void MeshSystem::SetLightParams(const glm::vec4& color, const glm::vec3& pos)
@@ -62,37 +356,287 @@ void MeshSystem::SetLightParams(const glm::vec4& color, const glm::vec3& pos)
     lightPos = pos;
 }
 
-size_t MeshSystem::AddObjectInstance(const SceneObject& obj)
+ObjectHandle MeshSystem::AddObjectInstance(const SceneObjectDesc& desc)
 {
-    SceneObject o = obj;
-    o.basePos = o.pos;
+    uint32_t slot;
+    if (!freeSlots.empty())
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        slot = (uint32_t)slots.size();
+        slots.emplace_back();
+    }
+
+    SceneObject o;
+    o.meshId = InternId(meshIds, meshOfId, desc.meshId);
+    o.textureId = InternId(textureIds, textureOfId, desc.textureId);
+    o.shaderId = InternId(shaderIds, shaderOfId, desc.shaderId);
+    o.pos = desc.pos;
+    o.scale = desc.scale;
+    o.motion = desc.motion;
+    o.rotSpeedDeg = desc.rotSpeedDeg;
+    o.bobAmp = desc.bobAmp;
+    o.bobFreq = desc.bobFreq;
+    o.basePos = desc.pos;
+
+    slots[slot].object = (uint32_t)objects.size();
     objects.push_back(o);
-    return objects.size() - 1;
+    objectNames.push_back(desc.name);
+    transforms.Add(o);
+    objectSlot.push_back(slot);
+    movedFlag.push_back(0);
+    bvhDirty = true;
+    motionParamsDirty = true;
+    gpuCullDirty = true;
+
+    const ObjectHandle h{ slot, slots[slot].generation };
+    objectByName.emplace(desc.name, h);
+    return h;
+}
+
+size_t MeshSystem::DenseIndex(ObjectHandle h) const
+{
+    if (h.slot >= slots.size() || slots[h.slot].generation != h.generation) return ~size_t(0);
+    return slots[h.slot].object;
+}
+
+ObjectHandle MeshSystem::HandleOf(size_t object) const
+{
+    const uint32_t slot = objectSlot[object];
+    return ObjectHandle{ slot, slots[slot].generation };
+}
+
+bool MeshSystem::RemoveObject(ObjectHandle h)
+{
+    const size_t i = DenseIndex(h);
+    if (i == ~size_t(0)) return false;
+
+    // Dense indices shift: flush pending edits while they still point at the right objects,
+    // then rebuild the BVH
+    ApplyMovedObjects(bvhTime);
+    bvhDirty = true;
+    motionParamsDirty = true;
+    gpuCullDirty = true;
+
+    const std::string name = std::move(objectNames[i]);
+
+    const size_t last = objects.size() - 1;
+    if (i != last)
+    {
+        objects[i] = objects[last];
+        objectNames[i] = std::move(objectNames[last]);
+        objectSlot[i] = objectSlot[last];
+        slots[objectSlot[i]].object = (uint32_t)i;
+    }
+    objects.pop_back();
+    objectNames.pop_back();
+    transforms.Remove((uint32_t)i);
+    objectSlot.pop_back();
+    movedFlag.pop_back();
+
+    slots[h.slot].generation++;
+    freeSlots.push_back(h.slot);
+
+    // Hand the name to a remaining duplicate, if any (removal is rare, so a scan is fine here)
+    auto it = objectByName.find(name);
+    if (it != objectByName.end() && it->second == h)
+    {
+        objectByName.erase(it);
+
+        for (size_t k = 0; k < objects.size(); k++)
+        {
+            if (objectNames[k] != name) continue;
+            objectByName.emplace(name, HandleOf(k));
+            break;
+        }
+    }
+
+    return true;
+}
+
+void MeshSystem::MarkMoved(size_t object)
+{
+    if (movedFlag[object]) return;
+    movedFlag[object] = 1;
+    movedObjects.push_back((uint32_t)object);
+}
+
+SceneObject* MeshSystem::GetObject(ObjectHandle h)
+{
+    const size_t i = DenseIndex(h);
+    if (i == ~size_t(0)) return nullptr;
+
+    MarkMoved(i);
+    return &objects[i];
+}
+
+ObjectHandle MeshSystem::FindObjectHandle(const std::string& name) const
+{
+    auto it = objectByName.find(name);
+    return it != objectByName.end() ? it->second : ObjectHandle{};
+}
+
+const std::string& MeshSystem::GetObjectName(ObjectHandle h) const
+{
+    static const std::string kEmpty;
+    const size_t i = DenseIndex(h);
+    return i != ~size_t(0) ? objectNames[i] : kEmpty;
 }
 
 SceneObject* MeshSystem::FindObject(const std::string& name)
 {
-    for (auto& o : objects)
-        if (o.name == name) return &o;
-    return nullptr;
+    return GetObject(FindObjectHandle(name));
 }
 
 MeshSystem::ShaderUniforms MeshSystem::GetShaderUniforms(Shader& s)
 {
-    auto it = uniformsByProgram.find(s.ID);
-    if (it != uniformsByProgram.end()) return it->second;
-
     ShaderUniforms u;
-    u.model = glGetUniformLocation(s.ID, "model");
     u.tex0 = glGetUniformLocation(s.ID, "tex0");
-    u.lightColor = glGetUniformLocation(s.ID, "lightColor");
-    u.lightPos = glGetUniformLocation(s.ID, "lightPos");
-    u.camPos = glGetUniformLocation(s.ID, "camPos");
+    u.diffuseColor = glGetUniformLocation(s.ID, "diffuseColor");
+    u.vertexDecode = glGetUniformLocation(s.ID, "vertexDecode");
+
+    // Unused inputs are not active, so this holds for shaders that declare but ignore them too
+    GLint attributes = 0, maxName = 0;
+    glGetProgramiv(s.ID, GL_ACTIVE_ATTRIBUTES, &attributes);
+    glGetProgramiv(s.ID, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxName);
 
-    uniformsByProgram.emplace(s.ID, u);
+    std::string name((size_t)std::max(maxName, 1), '\0');
+    u.positionOnly = true;
+    for (GLint i = 0; i < attributes; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveAttrib(s.ID, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, name.data());
+
+        const GLint location = glGetAttribLocation(s.ID, name.c_str());
+        if (location >= 1 && location < (GLint)INSTANCE_MATRIX_LOCATION)
+            u.positionOnly = false;
+    }
     return u;
 }
 
+void MeshSystem::SetGpuMotion(bool enabled)
+{
+    // Edits are not tracked while off, so the parameters are stale when turned back on
+    if (enabled && !gpuMotion) motionParamsDirty = true;
+    gpuMotion = enabled;
+}
+
+bool MeshSystem::SetGpuCulling(bool enabled)
+{
+    if (enabled && !gpuCuller.Init())
+    {
+        gpuCulling = false;
+        return false;
+    }
+
+    if (enabled && !gpuCulling)
+    {
+        motionParamsDirty = true;
+        gpuCullDirty = true;
+    }
+    gpuCulling = enabled;
+    return true;
+}
+
+bool MeshSystem::SetIndirectDraw(bool enabled)
+{
+    const GlExtensions& ext = GetGlExtensions();
+    if (enabled && !ext.multiDrawIndirect)
+    {
+        std::cout << "Multi-draw indirect needs GL 4.3, context is " << ext.major << "." << ext.minor << std::endl;
+        indirectDraw = false;
+        return false;
+    }
+
+    indirectDraw = enabled;
+    return true;
+}
+
+// Ring space one frame's uniform block needs, including the worst-case alignment padding
+size_t MeshSystem::FrameUniformsBytes()
+{
+    if (uniformAlignment == 0)
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    return sizeof(FrameUniforms) + (size_t)uniformAlignment;
+}
+
+// Into the frame's ring segment, bound as FrameData; false if the segment is full
+bool MeshSystem::UploadFrameUniforms(const FrameUniforms& f)
+{
+    FrameUniformsBytes();
+    const size_t offset = stream.Write(&f, sizeof(FrameUniforms), (size_t)uniformAlignment);
+    if (offset == StreamRing::kNoOffset) return false;
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, stream.Buffer(), (GLintptr)offset, sizeof(FrameUniforms));
+    return true;
+}
+
+// Brings the GPU motion buffer up to date and binds it; false if the scene is larger than
+// a buffer texture may be, then the frame falls back to CPU matrices
+bool MeshSystem::UploadMotionParams(size_t& uploadBytes)
+{
+    if (motionTexture == 0)
+    {
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxMotionTexels);
+        glGenBuffers(1, &motionBuffer);
+        glGenTextures(1, &motionTexture);
+
+        glBindBuffer(GL_TEXTURE_BUFFER, motionBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, motionTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, motionBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    const size_t texels = objects.size() * MOTION_TEXELS;
+    if (texels > (size_t)maxMotionTexels)
+    {
+        if (!motionLimitReported)
+            std::cout << "GPU motion: " << objects.size() << " objects exceed the buffer texture limit, using CPU matrices" << std::endl;
+        motionLimitReported = true;
+        motionParamsDirty = true;
+        motionEdits.clear();
+        return false;
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, motionBuffer);
+
+    if (motionParamsDirty)
+    {
+        std::vector<glm::vec4> params(texels);
+        for (size_t i = 0; i < objects.size(); i++)
+            PackMotionParams(objects[i], &params[i * MOTION_TEXELS]);
+
+        const GLsizeiptr bytes = (GLsizeiptr)(params.size() * sizeof(glm::vec4));
+        glBufferData(GL_TEXTURE_BUFFER, bytes, params.data(), GL_STATIC_DRAW);
+        uploadBytes += (size_t)bytes;
+        motionParamsDirty = false;
+    }
+    else
+    {
+        for (uint32_t i : motionEdits)
+        {
+            glm::vec4 row[MOTION_TEXELS];
+            PackMotionParams(objects[i], row);
+            glBufferSubData(GL_TEXTURE_BUFFER, (GLintptr)(i * sizeof(row)), sizeof(row), row);
+            uploadBytes += sizeof(row);
+        }
+    }
+    motionEdits.clear();
+
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glActiveTexture(GL_TEXTURE0 + MOTION_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, motionTexture);
+    glActiveTexture(GL_TEXTURE0);
+    return true;
+}
+
 glm::vec3 MeshSystem::GetWorldPos(const SceneObject& o, float t) const
 {
     if (o.motion == Motion::BobY)
@@ -103,96 +647,1050 @@ glm::vec3 MeshSystem::GetWorldPos(const SceneObject& o, float t) const
 
 glm::vec3 MeshSystem::GetWorldPosByName(const std::string& name, float t) const
 {
-    for (const auto& o : objects)
-        if (o.name == name) return GetWorldPos(o, t);
+    const size_t i = DenseIndex(FindObjectHandle(name));
+    return i != ~size_t(0) ? GetWorldPos(objects[i], t) : glm::vec3(0.0f);
+}
+
+// LSD radix sort of anything with a uint64_t key; stable, so equal keys keep their order.
+// Digits on which every key agrees are skipped, which drops most of the 8 passes in practice.
+template <typename Item>
+static void RadixSortByKey(std::vector<Item>& items, std::vector<Item>& scratch)
+{
+    const size_t n = items.size();
+    if (n < 2) return;
+
+    size_t counts[8][256] = {};
+    for (const Item& it : items)
+        for (int b = 0; b < 8; b++)
+            counts[b][(it.key >> (b * 8)) & 0xFF]++;
+
+    scratch.resize(n);
+    Item* src = items.data();
+    Item* dst = scratch.data();
+
+    for (int b = 0; b < 8; b++)
+    {
+        size_t* c = counts[b];
+        if (c[(src[0].key >> (b * 8)) & 0xFF] == n) continue;
+
+        size_t offset = 0;
+        for (int d = 0; d < 256; d++)
+        {
+            const size_t count = c[d];
+            c[d] = offset;
+            offset += count;
+        }
+
+        for (size_t i = 0; i < n; i++)
+            dst[c[(src[i].key >> (b * 8)) & 0xFF]++] = src[i];
+
+        std::swap(src, dst);
+    }
+
+    if (src != items.data())
+        items.swap(scratch);
+}
+
+bool MeshSystem::ResolveDraw(const SceneObject& o, unsigned int& shader, int& texture, unsigned int& mesh) const
+{
+    const int m = meshOfId[o.meshId];
+    const int s = shaderOfId[o.shaderId];
+    if (m < 0 || s < 0 || !shaderSlots[s]) return false;
+
+    shader = (unsigned int)s;
+    texture = textureOfId[o.textureId];
+    mesh = (unsigned int)m;
+    return true;
+}
 
-    return glm::vec3(0.0f);
+// Pixels one object-space unit covers at view depth 1 on this camera
+static float LodPixelsPerUnit(const Camera& camera)
+{
+    return 0.5f * float(camera.height) / std::tan(0.5f * glm::radians(CAMERA_FOV_DEG));
 }
 
-glm::mat4 MeshSystem::BuildModelMatrix(const SceneObject& o, float t) const
+// Coarsest level whose error, scaled with the object and projected at `depth` (the view depth of
+// the nearest point of its bounds), stays within lodThreshold pixels
+unsigned int MeshSystem::SelectLod(const GpuMesh& m, const SceneObject& o, float depth, float pixelsPerUnit) const
 {
-    glm::vec3 p = GetWorldPos(o, t);
+    if (m.lods.empty() || lodThreshold <= 0.0f) return 0;
+
+    const glm::vec3 s = glm::abs(o.scale);
+    const float pixels = std::max(s.x, std::max(s.y, s.z)) * pixelsPerUnit / std::max(depth, CAMERA_NEAR);
 
-    glm::mat4 model(1.0f);
-    model = glm::translate(model, p);
+    unsigned int lod = 0;
+    while (lod < m.lods.size() && m.lods[lod].error * pixels <= lodThreshold) lod++;
+    return lod;
+}
 
-    if (o.motion == Motion::RotateX)
-        model = glm::rotate(model, glm::radians(t * o.rotSpeedDeg), glm::vec3(1, 0, 0));
-    else if (o.motion == Motion::RotateY)
-        model = glm::rotate(model, glm::radians(t * o.rotSpeedDeg), glm::vec3(0, 1, 0));
-    else if (o.motion == Motion::RotateXY)
+void MeshSystem::GetWorldBounds(const SceneObject& o, const GpuMesh& m, float t,
+    glm::vec3& center, glm::vec3& extent, float& radius) const
+{
+    const glm::vec3 p = GetWorldPos(o, t);
+    const glm::vec3 s = glm::abs(o.scale);
+    const float maxScale = std::max(s.x, std::max(s.y, s.z));
+
+    if (IsRotating(o.motion))
+    {
+        // Orientation changes every frame: bound the mesh over all rotations about the pivot
+        center = p;
+        radius = glm::length(o.scale * m.boundsCenter) + m.boundsRadius * maxScale;
+        extent = glm::vec3(radius);
+    }
+    else
     {
-        model = glm::rotate(model, glm::radians(t * o.rotSpeedDeg), glm::vec3(1, 0, 0));
-        model = glm::rotate(model, glm::radians(t * o.rotSpeedDeg * 0.7f), glm::vec3(0, 1, 0));
+        center = p + o.scale * m.boundsCenter;
+        radius = m.boundsRadius * maxScale;
+        extent = s * m.boundsHalfExtent;
     }
+}
+
+void MeshSystem::RebuildBvh(float t)
+{
+    std::vector<SceneBvh::Item> items;
+    items.reserve(objects.size());
+    bvhDynamic.clear();
+
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        const SceneObject& o = objects[i];
+        const int mesh = meshOfId[o.meshId];
+        if (mesh < 0) continue;
 
-    model = glm::scale(model, o.scale);
-    return model;
+        glm::vec3 center, extent;
+        float radius;
+        GetWorldBounds(o, meshes[mesh], t, center, extent, radius);
+
+        SceneBvh::Item it;
+        it.min = center - extent;
+        it.max = center + extent;
+        it.id = (uint32_t)i;
+        items.push_back(it);
+
+        if (o.motion != Motion::None)
+            bvhDynamic.push_back((uint32_t)i);
+    }
+
+    bvh.Build(std::move(items));
+
+    bvhDirty = false;
+    bvhTime = t;
 }
 
-void MeshSystem::Render(Camera& camera, float t)
+void MeshSystem::RefitBvhObject(uint32_t i, float t)
+{
+    const SceneObject& o = objects[i];
+    const int mesh = meshOfId[o.meshId];
+    if (mesh < 0) return;
+
+    glm::vec3 center, extent;
+    float radius;
+    GetWorldBounds(o, meshes[mesh], t, center, extent, radius);
+    bvh.Update(i, center - extent, center + extent);
+}
+
+// Bounds of the moving objects in parallel, then the BVH updates (shared dirty lists) in order
+void MeshSystem::RefitBvhDynamic(float t)
+{
+    bvhRefit.resize(bvhDynamic.size());
+
+    ParallelFor(jobs, bvhDynamic.size(), JOB_GRAIN_OBJECTS, [&](size_t begin, size_t end)
+    {
+        for (size_t k = begin; k < end; k++)
+        {
+            const uint32_t i = bvhDynamic[k];
+            const SceneObject& o = objects[i];
+            const int mesh = meshOfId[o.meshId];
+
+            SceneBvh::Item& it = bvhRefit[k];
+            it.id = mesh >= 0 ? i : ~0u;   // unknown ids are ignored by Update
+            if (mesh < 0) continue;
+
+            glm::vec3 center, extent;
+            float radius;
+            GetWorldBounds(o, meshes[mesh], t, center, extent, radius);
+            it.min = center - extent;
+            it.max = center + extent;
+        }
+    });
+
+    for (const SceneBvh::Item& it : bvhRefit)
+        bvh.Update(it.id, it.min, it.max);
+}
+
+// Pushes edits made through GetObject/FindObject into the transform store and the BVH
+void MeshSystem::ApplyMovedObjects(float t)
 {
-    Shader* current = nullptr;
+    if (movedObjects.empty()) return;
+
+    for (uint32_t i : movedObjects)
+    {
+        transforms.Sync(i, objects[i]);
+        if (!bvhDirty) RefitBvhObject(i, t);
+
+        if ((gpuMotion || gpuCulling) && !motionParamsDirty) motionEdits.push_back(i);
+        else motionParamsDirty = true;
+
+        // A changed mesh, texture or shader moves the object to another draw group
+        if (!gpuCullDirty && i < gpuCullKeys.size())
+        {
+            unsigned int shader, mesh;
+            int texture;
+            const uint64_t key = ResolveDraw(objects[i], shader, texture, mesh)
+                ? MakeDrawKey(shader, texture, mesh, 0, 0.0f) : NO_CULL_KEY;
+            gpuCullDirty = key != gpuCullKeys[i];
+        }
+        movedFlag[i] = 0;
+    }
+    movedObjects.clear();
+
+    if (!bvhDirty) bvh.Refit();
+}
+
+void MeshSystem::UpdateBvh(float t)
+{
+    if (bvhDirty)
+    {
+        ApplyMovedObjects(t);
+        RebuildBvh(t);
+        return;
+    }
+
+    if (t == bvhTime && movedObjects.empty()) return;
+
+    if (t != bvhTime)
+        RefitBvhDynamic(t);
+
+    ApplyMovedObjects(t);
+    bvh.Refit();
+    bvhTime = t;
+
+    // Refits keep boxes exact but the split planes stale; rebuild once the tree has spread out
+    if (bvh.RootArea() > BVH_REBUILD_AREA_RATIO * bvh.BuildArea())
+        RebuildBvh(t);
+}
+
+ObjectHandle MeshSystem::Raycast(const glm::vec3& origin, const glm::vec3& dir, float t, float* hitDistance)
+{
+    UpdateBvh(t);
+
+    uint32_t id;
+    float dist;
+    if (!bvh.Raycast(origin, dir, std::numeric_limits<float>::max(), id, dist)) return ObjectHandle{};
+
+    if (hitDistance) *hitDistance = dist;
+    return HandleOf(id);
+}
+
+ObjectHandle MeshSystem::Raycast(const glm::vec3& origin, const glm::vec3& dir, float t,
+    const std::vector<ObjectHandle>& candidates, float* hitDistance)
+{
+    UpdateBvh(t);
+
+    // BVH ids are dense indices; resolve the handles once, dropping stale ones
+    std::vector<uint32_t> accepted;
+    for (ObjectHandle h : candidates)
+    {
+        const size_t i = DenseIndex(h);
+        if (i != ~size_t(0)) accepted.push_back((uint32_t)i);
+    }
+    if (accepted.empty()) return ObjectHandle{};
+
+    uint32_t id;
+    float dist;
+    const auto accept = [&](uint32_t item) { return std::find(accepted.begin(), accepted.end(), item) != accepted.end(); };
+    if (!bvh.Raycast(origin, dir, std::numeric_limits<float>::max(), id, dist, accept)) return ObjectHandle{};
+
+    if (hitDistance) *hitDistance = dist;
+    return HandleOf(id);
+}
+
+void MeshSystem::BuildDrawList(RenderSnapshot& frame, const Camera& camera, const glm::mat4& viewProj, float t)
+{
+    if (!culling || !bvhCulling)
+    {
+        BuildDrawListFlat(frame, camera, viewProj, t);
+        return;
+    }
+
+    std::vector<DrawItem>& drawList = frame.drawList;
+    RenderStats& frameStats = frame.stats;
+    drawList.clear();
+    UpdateBvh(t);
+
+    bvhVisible.clear();
+    bvh.Cull(Frustum::FromMatrix(viewProj), bvhVisible);
+
+    const glm::vec3 forward = glm::normalize(camera.Orientation);
+    const float pixelsPerUnit = LodPixelsPerUnit(camera);
+
+    // Keys in parallel into drawScratch (free until the sort); objects that cannot draw get ~0u
+    drawScratch.resize(bvhVisible.size());
+    ParallelFor(jobs, bvhVisible.size(), JOB_GRAIN_OBJECTS, [&](size_t begin, size_t end)
+    {
+        for (size_t k = begin; k < end; k++)
+        {
+            const uint32_t i = bvhVisible[k];
+            DrawItem& d = drawScratch[k];
+
+            unsigned int shader, mesh;
+            int texture;
+            if (!ResolveDraw(objects[i], shader, texture, mesh))
+            {
+                d.object = ~0u;
+                continue;
+            }
+
+            glm::vec3 lo, hi;
+            bvh.GetBounds(i, lo, hi);
+            const glm::vec3 center = 0.5f * (lo + hi);
+            const float depth = glm::dot(center - camera.Position, forward);
+            const unsigned int lod = SelectLod(meshes[mesh], objects[i], depth - 0.5f * glm::length(hi - lo), pixelsPerUnit);
+
+            d.key = MakeDrawKey(shader, texture, mesh, lod, depth);
+            d.object = i;
+        }
+    });
+
+    for (const DrawItem& d : drawScratch)
+    {
+        if (d.object == ~0u) continue;
+        drawList.push_back(d);
+        if (KeyLod(d.key) != 0) frameStats.coarseLods++;
+    }
+
+    frameStats.objects = (unsigned int)bvh.ItemCount();
+    frameStats.visible = (unsigned int)drawList.size();
+    frameStats.culled = frameStats.objects - frameStats.visible;
+
+    RadixSortByKey(drawList, drawScratch);
+}
+
+void MeshSystem::BuildDrawListFlat(RenderSnapshot& frame, const Camera& camera, const glm::mat4& viewProj, float t)
+{
+    const size_t count = objects.size();
+
+    std::vector<DrawItem>& drawList = frame.drawList;
+    RenderStats& frameStats = frame.stats;
+    drawList.clear();
+    drawScratch.resize(count);
+
+    cull.cx.resize(count); cull.cy.resize(count); cull.cz.resize(count); cull.radius.resize(count);
+    cull.ex.resize(count); cull.ey.resize(count); cull.ez.resize(count);
+    cull.resolved.resize(count);
+    cull.visible.resize(count);
+
+    const glm::vec3 forward = glm::normalize(camera.Orientation);
+    const float pixelsPerUnit = LodPixelsPerUnit(camera);
+    const Frustum frustum = Frustum::FromMatrix(viewProj);
+
+    // One slot per object: world bounds, draw key and visibility, written independently by each job.
+    // drawScratch is free until the sort.
+    ParallelFor(jobs, count, JOB_GRAIN_OBJECTS, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            const SceneObject& o = objects[i];
+
+            unsigned int shader, mesh;
+            int texture;
+            glm::vec3 center(0.0f), extent(0.0f);
+            float radius = 0.0f;
+
+            cull.resolved[i] = ResolveDraw(o, shader, texture, mesh) ? 1 : 0;
+            if (cull.resolved[i])
+            {
+                GetWorldBounds(o, meshes[mesh], t, center, extent, radius);
+
+                const float depth = glm::dot(center - camera.Position, forward);
+                const unsigned int lod = SelectLod(meshes[mesh], o, depth - radius, pixelsPerUnit);
+
+                DrawItem& d = drawScratch[i];
+                d.key = MakeDrawKey(shader, texture, mesh, lod, depth);
+                d.object = (unsigned int)i;
+            }
+
+            cull.cx[i] = center.x; cull.cy[i] = center.y; cull.cz[i] = center.z;
+            cull.radius[i] = radius;
+            cull.ex[i] = extent.x; cull.ey[i] = extent.y; cull.ez[i] = extent.z;
+        }
+
+        if (!culling) return;
+
+        const CullBounds b{ cull.cx.data() + begin, cull.cy.data() + begin, cull.cz.data() + begin,
+            cull.radius.data() + begin, cull.ex.data() + begin, cull.ey.data() + begin, cull.ez.data() + begin };
+        CullBoundsAgainstFrustum(frustum, b, end - begin, cull.visible.data() + begin);
+    });
+
+    frameStats.objects = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!cull.resolved[i]) continue;
+        frameStats.objects++;
+        if (culling && !cull.visible[i]) continue;
+
+        drawList.push_back(drawScratch[i]);
+        if (KeyLod(drawScratch[i].key) != 0) frameStats.coarseLods++;
+    }
+
+    frameStats.visible = (unsigned int)drawList.size();
+    frameStats.culled = frameStats.objects - frameStats.visible;
+
+    RadixSortByKey(drawList, drawScratch);
+}
+
+// Switches the bound VAO's instance attributes between the model matrix and the object index;
+// `enabled` is that VAO's flag in LayoutArena::objectInstances
+void MeshSystem::SetInstanceLayout(bool& enabled, bool objectIndices)
+{
+    if (enabled == objectIndices) return;
+
+    for (GLuint c = 0; c < 4; c++)
+    {
+        if (objectIndices) glDisableVertexAttribArray(INSTANCE_MATRIX_LOCATION + c);
+        else glEnableVertexAttribArray(INSTANCE_MATRIX_LOCATION + c);
+    }
+
+    if (objectIndices) glEnableVertexAttribArray(INSTANCE_OBJECT_LOCATION);
+    else glDisableVertexAttribArray(INSTANCE_OBJECT_LOCATION);
+
+    enabled = objectIndices;
+}
+
+// Binds an arena's VAO for this frame's instance data, the position-only one if asked for and the
+// arena has it. True if it was not bound: its instance attributes then still point wherever they
+// did last frame.
+bool MeshSystem::BindArena(unsigned int arena, bool positionOnly)
+{
+    LayoutArena& a = arenas[arena];
+    const bool positions = positionOnly && a.arena.PositionVao() != 0;
+    const GLuint vao = positions ? a.arena.PositionVao() : a.arena.Vao();
+
+    if (vao == boundVao)
+    {
+        stats.bindsAvoided++;
+        return false;
+    }
+
+    glBindVertexArray(vao);
+    SetInstanceLayout(a.objectInstances[positions ? 1 : 0], instanceObjects);
+    boundVao = vao;
+    stats.vaoBinds++;
+    return true;
+}
+
+// Position decode into the active program's uniform and, for meshes without a color stream,
+// the generic color attribute; both only when they change
+void MeshSystem::ApplyVertexState(unsigned int slot, const MeshVertexState& v)
+{
+    const ShaderUniforms& u = uniformsBySlot[slot];
+    if (u.vertexDecode != -1 && !(decodeBySlot[slot] == v.decode))
+    {
+        glUniform4fv(u.vertexDecode, 2, &v.decode.scale.x);
+        decodeBySlot[slot] = v.decode;
+    }
+
+    if (!v.colorStream && (!constantColorSet || constantColor != v.constantColor))
+    {
+        glVertexAttrib3f(VERTEX_COLOR_LOCATION, v.constantColor.x, v.constantColor.y, v.constantColor.z);
+        constantColor = v.constantColor;
+        constantColorSet = true;
+    }
+}
+
+// Instance attributes read from the bound GL_ARRAY_BUFFER, starting at instanceOffset + firstInstance
+void MeshSystem::PointInstanceAttributes(size_t firstInstance)
+{
+    if (instanceObjects)
+    {
+        glVertexAttribIPointer(INSTANCE_OBJECT_LOCATION, 1, GL_UNSIGNED_INT, sizeof(uint32_t),
+            (void*)(instanceOffset + firstInstance * sizeof(uint32_t)));
+        return;
+    }
+
+    const size_t base = instanceOffset + firstInstance * sizeof(glm::mat4);
+    for (GLuint c = 0; c < 4; c++)
+        glVertexAttribPointer(INSTANCE_MATRIX_LOCATION + c, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+            (void*)(base + c * sizeof(glm::vec4)));
+}
+
+void MeshSystem::DrawBatch(const DrawItem& d, const ShaderUniforms& u, size_t firstInstance, size_t instanceCount,
+    const ClusterRun* clusters, size_t clusterCount)
+{
+    const GpuMesh& m = meshes[KeyMesh(d.key)];
+
+    // No base-instance in GL 3.3: point the instance attributes at this batch's slice instead
+    BindArena(m.arena, u.positionOnly);
+    PointInstanceAttributes(firstInstance);
+    ApplyVertexState(KeyShader(d.key), m.vertexState);
+
+    const int objectTexture = (u.tex0 != -1) ? KeyTexture(d.key) : -1;
+
+    const std::vector<GpuSubMesh>& submeshes = LodSubmeshes(m, KeyLod(d.key));
+    for (size_t s = 0; s < submeshes.size(); s++)
+    {
+        const GpuSubMesh& sm = submeshes[s];
+
+        // With clusters, only this submesh's surviving ranges, in one multi-draw
+        if (clusters)
+        {
+            clusterCounts.clear();
+            clusterOffsets.clear();
+            for (size_t c = 0; c < clusterCount; c++)
+            {
+                if (clusters[c].submesh != s) continue;
+                clusterCounts.push_back(clusters[c].indexCount);
+                clusterOffsets.push_back((const void*)((m.firstIndex + clusters[c].indexOffset) * sizeof(GLuint)));
+            }
+            if (clusterCounts.empty()) continue;
+        }
+
+        const int tex = sm.texture >= 0 ? sm.texture : objectTexture;
+        if (tex >= 0)
+        {
+            if (tex != boundTexture)
+            {
+                textures[tex].Bind();
+                boundTexture = tex;
+                stats.textureBinds++;
+            }
+            else
+                stats.bindsAvoided++;
+        }
+
+        if (u.diffuseColor != -1)
+            glUniform3f(u.diffuseColor, sm.diffuse.x, sm.diffuse.y, sm.diffuse.z);
+
+        if (clusters)
+        {
+            // Non-instanced: instance 0 reads the attributes PointInstanceAttributes aimed at this object
+            clusterBaseVertices.assign(clusterCounts.size(), m.baseVertex);
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, clusterCounts.data(), GL_UNSIGNED_INT, clusterOffsets.data(),
+                (GLsizei)clusterCounts.size(), clusterBaseVertices.data());
+            for (GLsizei count : clusterCounts)
+                stats.triangles += size_t(count / 3);
+        }
+        else
+        {
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, sm.indexCount, GL_UNSIGNED_INT,
+                (void*)((m.firstIndex + sm.indexOffset) * sizeof(GLuint)), (GLsizei)instanceCount, m.baseVertex);
+            stats.triangles += instanceCount * size_t(sm.indexCount / 3);
+        }
+        stats.drawCalls++;
+    }
+
+    stats.batches++;
+}
+
+// Draws CullClusters picked go alone, with their runs
+bool MeshSystem::DrawsClusters(const RenderSnapshot& frame, size_t draw)
+{
+    return !frame.clusterDraws.empty() && frame.clusterDraws[draw];
+}
+
+// One DrawBatch per run of draws that share shader, texture and mesh (per draw without instancing
+// or with cluster culling); draws whose clusters were all culled are skipped
+void MeshSystem::SubmitBatches(const RenderSnapshot& frame)
+{
+    const std::vector<DrawItem>& drawList = frame.drawList;
+    unsigned int currentShader = ~0u;
     ShaderUniforms u;
 
-    for (auto& o : objects)
+    for (size_t first = 0; first < drawList.size(); )
     {
-        auto mi = meshById.find(o.meshId);
-        if (mi == meshById.end()) continue;
+        const DrawItem& d = drawList[first];
+        const bool clustered = DrawsClusters(frame, first);
 
-        auto si = shaderById.find(o.shaderId);
-        if (si == shaderById.end() || !si->second) continue;
+        size_t last = first + 1;
+        if (instancing && !clustered)
+            while (last < drawList.size() && SameState(drawList[last].key, d.key) && !DrawsClusters(frame, last)) last++;
 
-        Shader* s = si->second;
+        const uint32_t runFirst = clustered ? frame.clusterRunFirst[first] : 0;
+        const uint32_t runCount = clustered ? frame.clusterRunFirst[first + 1] - runFirst : 0;
+        if (clustered && runCount == 0)
+        {
+            first = last;
+            continue;
+        }
 
-        if (s != current)
+        const unsigned int slot = KeyShader(d.key);
+        if (slot != currentShader)
         {
-            current = s;
-            current->Activate();
-            camera.Matrix(45.0f, 0.1f, 50.0f, *current, "camMatrix");
-            u = GetShaderUniforms(*current);
+            currentShader = slot;
+            shaderSlots[slot]->Activate();
+            u = uniformsBySlot[slot];
+            stats.shaderBinds++;
+        }
+        else
+            stats.bindsAvoided++;
 
-            if (u.tex0 != -1)
-                glUniform1i(u.tex0, 0);
+        DrawBatch(d, u, first, last - first, clustered ? &frame.clusterRuns[runFirst] : nullptr, runCount);
+        first = last;
+    }
+}
+
+// Appends one indirect command per submesh of the key's mesh and LOD (per surviving cluster range
+// when clusters are given), drawing instanceCount instances from firstInstance, and extends the last
+// run or starts one when shader, texture, diffuse color, arena or vertex state change (the last two
+// only between meshes of other vertex layouts)
+void MeshSystem::AppendIndirectBatch(uint64_t key, size_t firstInstance, size_t instanceCount,
+    std::vector<IndirectRun>& runs, const ClusterRun* clusters, size_t clusterCount)
+{
+    const unsigned int slot = KeyShader(key);
+    const ShaderUniforms& u = uniformsBySlot[slot];
+    const GpuMesh& m = meshes[KeyMesh(key)];
+    const int objectTexture = (u.tex0 != -1) ? KeyTexture(key) : -1;
+
+    const std::vector<GpuSubMesh>& submeshes = LodSubmeshes(m, KeyLod(key));
+    for (size_t s = 0; s < submeshes.size(); s++)
+    {
+        const GpuSubMesh& sm = submeshes[s];
+        const int tex = sm.texture >= 0 ? sm.texture : objectTexture;
+        const glm::vec3 diffuse = (u.diffuseColor != -1) ? sm.diffuse : glm::vec3(1.0f);
+
+        for (size_t c = 0; c < (clusters ? clusterCount : 1); c++)
+        {
+            if (clusters && clusters[c].submesh != s) continue;
+
+            if (runs.empty() || runs.back().shader != slot || runs.back().texture != tex || runs.back().diffuse != diffuse
+                || runs.back().arena != m.arena || !(runs.back().vertexState == m.vertexState))
+            {
+                IndirectRun r;
+                r.first = indirectCommands.size();
+                r.shader = slot;
+                r.texture = tex;
+                r.diffuse = diffuse;
+                r.arena = m.arena;
+                r.vertexState = m.vertexState;
+                runs.push_back(r);
+            }
+            runs.back().count++;
+
+            DrawElementsIndirectCommand cmd;
+            cmd.count = (GLuint)(clusters ? clusters[c].indexCount : sm.indexCount);
+            cmd.instanceCount = (GLuint)instanceCount;
+            cmd.firstIndex = m.firstIndex + (clusters ? clusters[c].indexOffset : sm.indexOffset);
+            cmd.baseVertex = m.baseVertex;
+            cmd.baseInstance = (GLuint)firstInstance;
+            indirectCommands.push_back(cmd);
+            stats.triangles += instanceCount * size_t(cmd.count / 3);
         }
+    }
+}
 
-        if (u.lightColor != -1)
-            glUniform4f(u.lightColor, lightColor.x, lightColor.y, lightColor.z, lightColor.w);
+// One glMultiDrawElementsIndirect per run, reading the bound draw indirect buffer. Instance
+// attributes start at instanceOffset of the bound array buffer; baseInstance picks the rest.
+void MeshSystem::DrawIndirectRuns(const std::vector<IndirectRun>& runs)
+{
+    const GlExtensions& ext = GetGlExtensions();
+    unsigned int currentShader = ~0u;
 
-        if (u.lightPos != -1)
-            glUniform3f(u.lightPos, lightPos.x, lightPos.y, lightPos.z);
+    for (const IndirectRun& r : runs)
+    {
+        const ShaderUniforms& u = uniformsBySlot[r.shader];
+        if (r.shader != currentShader)
+        {
+            currentShader = r.shader;
+            shaderSlots[r.shader]->Activate();
+            stats.shaderBinds++;
+        }
+        else
+            stats.bindsAvoided++;
 
-        if (u.camPos != -1)
-            glUniform3f(u.camPos, camera.Position.x, camera.Position.y, camera.Position.z);
+        if (BindArena(r.arena, u.positionOnly))
+            PointInstanceAttributes(0);
+        ApplyVertexState(r.shader, r.vertexState);
 
-        glm::mat4 model = BuildModelMatrix(o, t);
-        if (u.model != -1)
-            glUniformMatrix4fv(u.model, 1, GL_FALSE, glm::value_ptr(model));
+        if (r.texture >= 0)
+        {
+            if (r.texture != boundTexture)
+            {
+                textures[r.texture].Bind();
+                boundTexture = r.texture;
+                stats.textureBinds++;
+            }
+            else
+                stats.bindsAvoided++;
+        }
+
+        if (u.diffuseColor != -1)
+            glUniform3f(u.diffuseColor, r.diffuse.x, r.diffuse.y, r.diffuse.z);
+
+        ext.MultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+            (void*)(r.first * sizeof(DrawElementsIndirectCommand)), (GLsizei)r.count, 0);
+        stats.drawCalls++;
+    }
+}
 
-        if (u.tex0 != -1)
+// Same batches as the DrawBatch loop, but every submesh draw becomes an indirect command and a run
+// of commands with the same shader, texture and diffuse color is one multi-draw. Each command's
+// baseInstance selects its instances, so the attributes stay pointed at the frame's first instance.
+void MeshSystem::SubmitIndirect(const RenderSnapshot& frame)
+{
+    const std::vector<DrawItem>& drawList = frame.drawList;
+    indirectCommands.clear();
+    indirectRuns.clear();
+
+    for (size_t first = 0; first < drawList.size(); )
+    {
+        const DrawItem& d = drawList[first];
+        const bool clustered = DrawsClusters(frame, first);
+
+        size_t last = first + 1;
+        if (instancing && !clustered)
+            while (last < drawList.size() && SameState(drawList[last].key, d.key) && !DrawsClusters(frame, last)) last++;
+
+        const uint32_t runFirst = clustered ? frame.clusterRunFirst[first] : 0;
+        const uint32_t runCount = clustered ? frame.clusterRunFirst[first + 1] - runFirst : 0;
+        if (!clustered || runCount > 0)
         {
-            auto ti = textureById.find(o.textureId);
-            if (ti != textureById.end())
+            AppendIndirectBatch(d.key, first, last - first, indirectRuns,
+                clustered ? &frame.clusterRuns[runFirst] : nullptr, runCount);
+            stats.batches++;
+        }
+        first = last;
+    }
+
+    if (indirectBuffer == 0)
+        glGenBuffers(1, &indirectBuffer);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+    const GLsizeiptr bytes = (GLsizeiptr)(indirectCommands.size() * sizeof(DrawElementsIndirectCommand));
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, bytes, indirectCommands.data(), GL_STREAM_DRAW);
+    stats.uploadBytes += (size_t)bytes;
+    stats.indirectDraws += (unsigned int)indirectCommands.size();
+
+    DrawIndirectRuns(indirectRuns);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+// Groups the drawable objects by (shader, texture, mesh) in draw-key order and hands the culler
+// each object's local bounds and group, the group slices and one command per group submesh
+void MeshSystem::BuildGpuCullScene()
+{
+    const size_t n = objects.size();
+    gpuCullKeys.resize(n);
+
+    std::vector<uint64_t> groupKeys;
+    for (size_t i = 0; i < n; i++)
+    {
+        unsigned int shader, mesh;
+        int texture;
+        gpuCullKeys[i] = ResolveDraw(objects[i], shader, texture, mesh)
+            ? MakeDrawKey(shader, texture, mesh, 0, 0.0f) : NO_CULL_KEY;
+        if (gpuCullKeys[i] != NO_CULL_KEY) groupKeys.push_back(gpuCullKeys[i]);
+    }
+    std::sort(groupKeys.begin(), groupKeys.end());
+    groupKeys.erase(std::unique(groupKeys.begin(), groupKeys.end()), groupKeys.end());
+
+    std::vector<GpuCuller::Object> records(n);
+    std::vector<GLuint> groupBase(groupKeys.size() + 1, 0);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (gpuCullKeys[i] == NO_CULL_KEY) continue;
+
+        const GLuint g = (GLuint)(std::lower_bound(groupKeys.begin(), groupKeys.end(), gpuCullKeys[i]) - groupKeys.begin());
+        const GpuMesh& m = meshes[KeyMesh(gpuCullKeys[i])];
+        records[i].center = glm::vec4(m.boundsCenter, m.boundsRadius);
+        records[i].extent = glm::vec4(m.boundsHalfExtent, 0.0f);
+        records[i].info.x = g;
+        groupBase[g + 1]++;
+    }
+    for (size_t g = 1; g < groupBase.size(); g++)
+        groupBase[g] += groupBase[g - 1];
+
+    // instanceCount stays 0 here: stage 1 of the culler writes it every frame
+    indirectCommands.clear();
+    gpuCullRuns.clear();
+    std::vector<GLuint> commandGroup;
+    for (size_t g = 0; g < groupKeys.size(); g++)
+    {
+        AppendIndirectBatch(groupKeys[g], groupBase[g], 0, gpuCullRuns);
+        commandGroup.resize(indirectCommands.size(), (GLuint)g);
+    }
+
+    const size_t visibleSlots = groupBase.back();
+    groupBase.pop_back();
+    stats.uploadBytes += gpuCuller.SetScene(records, groupBase, visibleSlots, indirectCommands, commandGroup);
+    gpuCullGroups = (unsigned int)groupKeys.size();
+    gpuCullDirty = false;
+}
+
+// Culls on the GPU and draws the result without reading it back: the commands and the visible
+// object list the culler wrote feed glMultiDrawElementsIndirect and the object index attribute
+void MeshSystem::RenderGpuCulled(const Camera& camera, float t, size_t motionBytes)
+{
+    stats = RenderStats{};
+    stats.objects = (unsigned int)objects.size();
+    stats.uploadBytes = motionBytes;
+
+    if (gpuCullDirty)
+        BuildGpuCullScene();
+
+    FrameUniforms f;
+    const glm::mat4 viewProj = FillFrameUniforms(f, camera, t, true);
+
+    gpuCuller.Cull(Frustum::FromMatrix(viewProj), t, motionBuffer);
+
+    if (gpuCullReadback)
+    {
+        stats.visible = (unsigned int)gpuCuller.ReadVisibleCount();
+        stats.culled = stats.objects - stats.visible;
+    }
+
+    stream.BeginFrame(FrameUniformsBytes());
+    if (!UploadFrameUniforms(f))
+    {
+        stream.EndFrame();
+        return;
+    }
+
+    instanceObjects = true;
+    instanceOffset = 0;
+    boundVao = 0;
+    glBindBuffer(GL_ARRAY_BUFFER, gpuCuller.VisibleBuffer());
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, gpuCuller.CommandBuffer());
+
+    glActiveTexture(GL_TEXTURE0);
+    boundTexture = -1;
+    DrawIndirectRuns(gpuCullRuns);
+    stats.batches = gpuCullGroups;
+    stats.indirectDraws = (unsigned int)gpuCuller.CommandCount();
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    boundTexture = -1;
+    stream.EndFrame();
+}
+
+void MeshSystem::Render(Camera& camera, float t)
+{
+    // Edits first, so GPU motion uploads them before the frame is built
+    ApplyMovedObjects(t);
+
+    // GPU culling animates from the motion parameters too; both fall back to CPU matrices past
+    // the buffer texture limit
+    size_t motionBytes = 0;
+    const bool objectIndices = (gpuMotion || gpuCulling) && UploadMotionParams(motionBytes);
+
+    if (gpuCulling && objectIndices)
+    {
+        RenderGpuCulled(camera, t, motionBytes);
+        return;
+    }
+
+    PrepareFrame(renderFrame, camera, t, objectIndices);
+    renderFrame.stats.uploadBytes += motionBytes;
+    Submit(renderFrame);
+}
+
+void MeshSystem::Prepare(RenderSnapshot& frame, const Camera& camera, float t)
+{
+    PrepareFrame(frame, camera, t, false);
+
+    // Nothing uploads GPU motion edits on this path: drop them, Render re-sends everything
+    if (!motionEdits.empty())
+    {
+        motionEdits.clear();
+        motionParamsDirty = true;
+    }
+}
+
+// Returns the view-projection matrix it stored
+glm::mat4 MeshSystem::FillFrameUniforms(FrameUniforms& f, const Camera& camera, float t, bool objectIndices) const
+{
+    f.camMatrix = camera.ViewProjection(CAMERA_FOV_DEG, CAMERA_NEAR, CAMERA_FAR);
+    f.camPos = glm::vec4(camera.Position, 1.0f);
+    f.lightColor = lightColor;
+    f.lightPos = glm::vec4(lightPos, 1.0f);
+    f.motionTime = glm::vec4(t, objectIndices ? 1.0f : 0.0f, 0.0f, 0.0f);
+    return f.camMatrix;
+}
+
+void MeshSystem::PrepareFrame(RenderSnapshot& frame, const Camera& camera, float t, bool objectIndices)
+{
+    frame.stats = RenderStats{};
+    frame.objectInstances = objectIndices;
+
+    const glm::mat4 viewProj = FillFrameUniforms(frame.uniforms, camera, t, objectIndices);
+
+    ApplyMovedObjects(t);
+    BuildDrawList(frame, camera, viewProj, t);
+
+    frame.drawObjects.resize(frame.drawList.size());
+    for (size_t i = 0; i < frame.drawList.size(); i++)
+        frame.drawObjects[i] = frame.drawList[i].object;
+
+    // Model matrices in draw order, unless the vertex shader animates from object indices
+    if (objectIndices)
+    {
+        frame.instanceMatrices.clear();
+    }
+    else
+    {
+        frame.instanceMatrices.resize(frame.drawObjects.size());
+        ParallelFor(jobs, frame.drawObjects.size(), JOB_GRAIN_MATRICES, [&](size_t begin, size_t end)
+        {
+            transforms.Evaluate(frame.drawObjects.data() + begin, end - begin, t, frame.instanceMatrices.data() + begin);
+        });
+    }
+
+    CullClusters(frame, camera, viewProj, t);
+}
+
+// Full-detail draws of meshes with meshlets whose bounds cross a frustum plane (or all of them, with
+// cone culling): meshlets tested in the object's local space against the frustum and, if enabled,
+// the backface cone; survivors next to each other in one submesh merge into one run. Draws fully
+// inside have nothing to cull and stay instanced.
+void MeshSystem::CullClusters(RenderSnapshot& frame, const Camera& camera, const glm::mat4& viewProj, float t)
+{
+    frame.clusterDraws.clear();
+    frame.clusterRunFirst.clear();
+    frame.clusterRuns.clear();
+    if (!clusterCulling || !hasMeshlets) return;
+
+    const Frustum frustum = Frustum::FromMatrix(viewProj);
+    const size_t n = frame.drawList.size();
+    frame.clusterDraws.assign(n, 0);
+    frame.clusterRunFirst.resize(n + 1);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        frame.clusterRunFirst[i] = (uint32_t)frame.clusterRuns.size();
+        const uint64_t key = frame.drawList[i].key;
+        const GpuMesh& mesh = meshes[KeyMesh(key)];
+        if (KeyLod(key) != 0 || mesh.meshlets.empty()) continue;
+
+        glm::mat4 model;
+        if (frame.objectInstances) transforms.Evaluate(&frame.drawObjects[i], 1, t, &model);
+        else model = frame.instanceMatrices[i];
+
+        const Frustum local = frustum.Transformed(model);
+
+        // A mirroring scale flips the winding, and with it which side of a cone faces away
+        const bool cones = clusterConeCulling && glm::determinant(glm::mat3(model)) > 0.0f;
+        if (!cones && local.TestBox(mesh.boundsCenter - mesh.boundsHalfExtent, mesh.boundsCenter + mesh.boundsHalfExtent)
+            == FrustumTest::Inside)
+            continue;
+
+        frame.clusterDraws[i] = 1;
+        const glm::vec3 eye = glm::vec3(glm::inverse(model) * glm::vec4(camera.Position, 1.0f));
+
+        for (const Meshlet& c : mesh.meshlets)
+        {
+            if (!local.TestSphere(c.center, c.radius) || (cones && MeshletBuilder::IsBackfacing(c, eye)))
+            {
+                frame.stats.clustersCulled++;
+                continue;
+            }
+            frame.stats.clustersVisible++;
+
+            if (frame.clusterRuns.size() > frame.clusterRunFirst[i])
             {
-                glActiveTexture(GL_TEXTURE0);   
-                textures[ti->second].Bind();
+                ClusterRun& last = frame.clusterRuns.back();
+                if (last.submesh == c.submesh && last.indexOffset + (GLuint)last.indexCount == c.indexOffset)
+                {
+                    last.indexCount += c.indexCount;
+                    continue;
+                }
             }
+            frame.clusterRuns.push_back(ClusterRun{ c.submesh, c.indexOffset, c.indexCount });
         }
+    }
+    frame.clusterRunFirst[n] = (uint32_t)frame.clusterRuns.size();
+}
+
+void MeshSystem::Submit(const RenderSnapshot& frame)
+{
+    stats = frame.stats;
+
+    const std::vector<DrawItem>& drawList = frame.drawList;
+    if (drawList.empty()) return;
+
+    instanceObjects = frame.objectInstances;
 
-        GpuMesh& m = meshes[mi->second];
-        m.vao.Bind();
-        glDrawElements(GL_TRIANGLES, m.indexCount, GL_UNSIGNED_INT, 0);
+    // Instance data in draw order (object indices with GPU motion, model matrices otherwise) and the
+    // uniform block, written into this frame's ring segment. The ring stays bound for the whole
+    // frame: DrawBatch only re-points attributes into it.
+    const size_t bytes = instanceObjects
+        ? frame.drawObjects.size() * sizeof(uint32_t)
+        : frame.instanceMatrices.size() * sizeof(glm::mat4);
+
+    stream.BeginFrame(bytes + INSTANCE_ALIGNMENT + FrameUniformsBytes());
+    instanceOffset = stream.Write(
+        instanceObjects ? (const void*)frame.drawObjects.data() : (const void*)frame.instanceMatrices.data(),
+        bytes, INSTANCE_ALIGNMENT);
+
+    if (instanceOffset == StreamRing::kNoOffset || !UploadFrameUniforms(frame.uniforms))
+    {
+        stream.EndFrame();
+        return;
     }
+    stats.uploadBytes += bytes;
+    glBindBuffer(GL_ARRAY_BUFFER, stream.Buffer());
+
+    // One VAO per vertex layout: with a single layout it is bound once for the whole frame
+    boundVao = 0;
+
+    glActiveTexture(GL_TEXTURE0);
+    boundTexture = -1;
+
+    if (indirectDraw)
+        SubmitIndirect(frame);
+    else
+        SubmitBatches(frame);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    boundTexture = -1;
+    stream.EndFrame();
 }
 
 void MeshSystem::Shutdown()
 {
-    for (auto& m : meshes) { m.vao.Delete(); m.vbo.Delete(); m.ebo.Delete(); }
+    for (LayoutArena& a : arenas) a.arena.Delete();
+    arenas.clear();
+    boundVao = 0;
+    constantColorSet = false;
+    hasMeshlets = false;
     for (auto& t : textures) t.Delete();
+    stream.Delete();
+    if (indirectBuffer) glDeleteBuffers(1, &indirectBuffer);
+    gpuCuller.Delete();
+    if (motionBuffer) glDeleteBuffers(1, &motionBuffer);
+    if (motionTexture) glDeleteTextures(1, &motionTexture);
+    indirectBuffer = 0;
+    motionBuffer = 0;
+    motionTexture = 0;
+    motionParamsDirty = true;
+    motionLimitReported = false;
+    motionEdits.clear();
+    gpuCullDirty = true;
+    gpuCullKeys.clear();
+    gpuCullRuns.clear();
 
-    meshes.clear(); meshById.clear();
-    textures.clear(); textureById.clear();
+    meshes.clear(); meshIds.Clear(); meshOfId.clear();
+    textures.clear(); textureIds.Clear(); textureOfId.clear();
     objects.clear();
-    shaderById.clear();
-    uniformsByProgram.clear();
+    objectNames.clear();
+    transforms.Clear();
+    objectSlot.clear();
+    slots.clear();
+    freeSlots.clear();
+    objectByName.clear();
+    bvh.Clear();
+    bvhDirty = true;
+    bvhDynamic.clear();
+    movedObjects.clear();
+    movedFlag.clear();
+    bvhVisible.clear();
+    shaderSlots.clear();
+    shaderIds.Clear();
+    shaderOfId.clear();
+    uniformsBySlot.clear();
+    decodeBySlot.clear();
+    renderFrame = RenderSnapshot{};
+    drawScratch.clear();
 }
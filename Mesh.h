@@ -2,44 +2,139 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
 #include <unordered_map>
 #include <glm/glm.hpp>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-#include "VAO.h"
-#include "VBO.h"
-#include "EBO.h"
+#include "MeshArena.h"
+#include "VertexLayout.h"
+#include "GlExtensions.h"
+#include "GpuCuller.h"
+#include "StreamRing.h"
 #include "Texture.h"
 #include "shapes.h"
 #include "shaderClass.h"
 #include "Camera.h"
+#include "Frustum.h"
+#include "SceneBvh.h"
+#include "StringInterner.h"
+#include "TransformStore.h"
+#include "JobSystem.h"
 
 enum class Motion { None, BobY, RotateX, RotateY, RotateXY };
 
+struct MeshMaterial
+{
+    std::string name;
+    glm::vec3 diffuse{ 1.0f };
+    std::string diffuseMap;     // texture path, empty if none
+};
+
+// Contiguous index range drawn with one material
+struct SubMesh
+{
+    unsigned int material = 0;
+    GLuint indexOffset = 0;
+    GLsizei indexCount = 0;
+};
+
+// A coarser version of a mesh: its own ranges into the same vertices and index buffer
+struct MeshLod
+{
+    std::vector<SubMesh> submeshes;
+    float error = 0.0f;         // object-space distance its surface may stray from the full mesh
+};
+
+// A cluster of up to 124 neighbouring triangles from one full-detail submesh, bounded for
+// culling by a sphere and a cone holding every triangle normal (see MeshletBuilder)
+struct Meshlet
+{
+    GLuint indexOffset = 0;     // into the mesh's indices, inside its submesh's range
+    GLsizei indexCount = 0;
+    unsigned int submesh = 0;
+
+    glm::vec3 center{ 0.0f };   // local space
+    float radius = 0.0f;
+    glm::vec3 coneAxis{ 0.0f, 0.0f, 1.0f };
+    float coneCutoff = 1.0f;    // sine of the cone's half angle; 1 = normals too spread to cull
+};
+
 struct CpuMeshData
 {
     std::vector<float> vertices;
     std::vector<GLuint> indices;
+
+    // Empty submeshes = one range over all indices with the default material
+    std::vector<MeshMaterial> materials;
+    std::vector<SubMesh> submeshes;
+
+    // Coarser levels, increasing error; their ranges follow the full mesh's in indices,
+    // so a mesh with levels always has submeshes
+    std::vector<MeshLod> lods;
+
+    // Clusters of the full-detail ranges in index order, empty if the mesh was not split
+    std::vector<Meshlet> meshlets;
+
+    // Material libraries the loader looked for (found or not), for cache invalidation
+    std::vector<std::string> materialLibs;
 };
 
-struct GpuMesh
+struct GpuSubMesh
+{
+    GLuint indexOffset = 0;
+    GLsizei indexCount = 0;
+    glm::vec3 diffuse{ 1.0f };
+    int texture = -1;           // index into textures, -1 = use the object's texture
+};
+
+struct GpuMeshLod
+{
+    std::vector<GpuSubMesh> submeshes;
+    float error = 0.0f;         // see MeshLod
+};
+
+// Per-mesh vertex shader state: the vertexDecode uniform and, without a color stream, the
+// generic value of the color attribute
+struct MeshVertexState
 {
-    VAO vao;
-    VBO vbo;
-    EBO ebo;
-    GLsizei indexCount;
+    VertexDecode decode;
+    bool colorStream = true;
+    glm::vec3 constantColor{ 1.0f };
 
-    GpuMesh(const void* vtx, GLsizeiptr vtxSize,
-        const void* idx, GLsizeiptr idxSize,
-        GLsizei count)
-        : vao(), vbo(vtx, vtxSize), ebo(idx, idxSize), indexCount(count)
+    bool operator==(const MeshVertexState& o) const
     {
+        return decode == o.decode && colorStream == o.colorStream
+            && (colorStream || constantColor == o.constantColor);
     }
 };
 
-struct SceneObject
+// A mesh's slice of its layout's arena; indices are relative to baseVertex
+struct GpuMesh
+{
+    unsigned int arena = 0;     // index into MeshSystem::arenas
+    GLint baseVertex = 0;
+    GLuint firstIndex = 0;
+    GLsizei indexCount = 0;         // all levels
+    std::vector<GpuSubMesh> submeshes;
+    std::vector<GpuMeshLod> lods;   // coarser levels: level n draws lods[n - 1]
+    std::vector<Meshlet> meshlets;  // of the full-detail level
+
+    GLsizei vertexCount = 0;
+    unsigned int vertexStride = 0;  // bytes
+    unsigned int positionStride = 0;    // of the position stream, 0 without one
+    MeshVertexState vertexState;
+
+    // Local-space bounds, both centered on the AABB center
+    glm::vec3 boundsCenter{ 0.0f };
+    glm::vec3 boundsHalfExtent{ 0.0f };
+    float boundsRadius = 0.0f;
+};
+
+// What callers pass to AddObjectInstance; resources are referenced by their registration ids
+struct SceneObjectDesc
 {
     std::string name;
     std::string meshId;
@@ -49,6 +144,23 @@ struct SceneObject
     glm::vec3 pos{ 0.0f };
     glm::vec3 scale{ 1.0f };
 
+    Motion motion = Motion::None;
+    float rotSpeedDeg = 0.0f;
+    float bobAmp = 0.0f;
+    float bobFreq = 0.0f;
+};
+
+// Stored form: resource ids are interned once by AddObjectInstance, so the per-frame
+// passes index arrays instead of hashing strings. Resources may be registered later.
+struct SceneObject
+{
+    uint32_t meshId = 0;
+    uint32_t textureId = 0;
+    uint32_t shaderId = 0;
+
+    glm::vec3 pos{ 0.0f };
+    glm::vec3 scale{ 1.0f };
+
     Motion motion = Motion::None;
     float rotSpeedDeg = 0.0f;
     float bobAmp = 0.0f;
@@ -56,54 +168,355 @@ struct SceneObject
     glm::vec3 basePos{ 0.0f };
 };
 
+// Stable reference to a scene object; stale once the object is removed (generation mismatch)
+struct ObjectHandle
+{
+    uint32_t slot = ~0u;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return slot != ~0u; }
+    bool operator==(const ObjectHandle& o) const { return slot == o.slot && generation == o.generation; }
+    bool operator!=(const ObjectHandle& o) const { return !(*this == o); }
+};
+
+// Mirrors `layout (std140) uniform FrameData` in the shaders; vec3s are padded to vec4
+struct FrameUniforms
+{
+    glm::mat4 camMatrix{ 1.0f };
+    glm::vec4 camPos{ 0.0f };
+    glm::vec4 lightColor{ 1.0f };
+    glm::vec4 lightPos{ 0.0f };
+    glm::vec4 motionTime{ 0.0f };   // x = seconds, y = 1 with GPU motion
+};
+static_assert(sizeof(FrameUniforms) == 128, "FrameUniforms must match the std140 block");
+
+// Per-frame counters, reset at the start of Render
+struct RenderStats
+{
+    unsigned int objects = 0;       // objects submitted
+    unsigned int visible = 0;       // passed frustum culling
+    unsigned int culled = 0;
+    unsigned int batches = 0;       // (mesh, shader, texture) groups
+    unsigned int drawCalls = 0;
+
+    // State changes issued vs. skipped because the state was already bound
+    unsigned int shaderBinds = 0;
+    unsigned int textureBinds = 0;
+    unsigned int vaoBinds = 0;
+    unsigned int bindsAvoided = 0;
+
+    size_t uploadBytes = 0;         // instance, motion and indirect command data sent to the GPU
+    unsigned int indirectDraws = 0; // commands behind the multi-draw indirect calls in drawCalls
+
+    size_t triangles = 0;           // drawn, over all instances; unknown (0) with GPU culling
+    unsigned int coarseLods = 0;    // visible objects drawn below full detail
+
+    unsigned int clustersVisible = 0;   // meshlets of visible objects that passed cluster culling
+    unsigned int clustersCulled = 0;
+};
+
+// GPU memory of one mesh in its vertex layout vs. the full 44-byte vertex
+struct MeshMemoryStats
+{
+    std::string id;
+    size_t vertices = 0;
+    size_t indices = 0;
+    unsigned int vertexStride = 0;
+    unsigned int positionStride = 0;    // 0 without a position stream
+    size_t bytes = 0;               // vertices, position stream and indices as stored
+    size_t fullBytes = 0;           // the same with VertexLayout::Full
+};
+
+// key = shader slot | texture + 1 | mesh | LOD | view depth, see MakeDrawKey in Mesh.cpp
+struct DrawItem
+{
+    uint64_t key = 0;
+    unsigned int object = 0;
+};
+
+// Consecutive visible meshlets of one submesh, drawn as one index range
+struct ClusterRun
+{
+    unsigned int submesh = 0;
+    GLuint indexOffset = 0;
+    GLsizei indexCount = 0;
+};
+
+// One frame as MeshSystem::Prepare leaves it for Submit: sorted draws, per-instance data in
+// draw order and the uniform block. Owns copies of everything, so it stays valid while the
+// scene moves on.
+struct RenderSnapshot
+{
+    FrameUniforms uniforms;
+    std::vector<DrawItem> drawList;
+    std::vector<uint32_t> drawObjects;     // drawList[i].object
+    std::vector<glm::mat4> instanceMatrices;
+    bool objectInstances = false;          // instances are object indices for GPU motion, no matrices
+    RenderStats stats;                     // culling counts; Submit adds binds and uploads
+
+    // With cluster culling, draw i with clusterDraws[i] set draws only
+    // clusterRuns[clusterRunFirst[i] .. clusterRunFirst[i + 1]); empty = no cluster culling
+    std::vector<uint8_t> clusterDraws;
+    std::vector<uint32_t> clusterRunFirst;
+    std::vector<ClusterRun> clusterRuns;
+};
+
 class MeshSystem
 {
 public:
     void AddMesh(const std::string& id, const CpuMeshData& data);
+    void AddMesh(const std::string& id, const float* vertices, size_t vertexFloatCount,
+        const GLuint* indices, size_t indexCount,
+        const std::vector<MeshMaterial>& materials = {}, const std::vector<SubMesh>& submeshes = {},
+        const std::vector<MeshLod>& lods = {}, const std::vector<Meshlet>& meshlets = {});
     void AddPrimitiveMesh(const std::string& id, gfx::ShapeType type);
+    // Vertex format of the meshes added from now on; each format gets its own arena. Default Full.
+    void SetVertexLayout(const VertexLayout& layout) { vertexLayout = layout; }
+    std::vector<MeshMemoryStats> GetMeshMemory() const;
 
     void AddTexture(const std::string& id, const std::string& filePath, GLenum format = GL_RGB);
 
     void RegisterShaderProgram(const std::string& id, Shader& shader);
     void SetLightParams(const glm::vec4& color, const glm::vec3& pos);
 
-    size_t AddObjectInstance(const SceneObject& obj);
+    ObjectHandle AddObjectInstance(const SceneObjectDesc& desc);
+    bool RemoveObject(ObjectHandle h);
+
+    // Objects may be moved through the returned pointers; they are refit in the BVH on the next query.
+    // nullptr for stale handles and unknown names; with duplicate names the first added wins while it lives.
+    SceneObject* GetObject(ObjectHandle h);
     SceneObject* FindObject(const std::string& name);
+    ObjectHandle FindObjectHandle(const std::string& name) const;
+    const std::string& GetObjectName(ObjectHandle h) const;    // empty for stale handles
+
+    // Nearest object whose world bounds the ray hits, invalid handle if none
+    ObjectHandle Raycast(const glm::vec3& origin, const glm::vec3& dir, float timeSec, float* hitDistance = nullptr);
+    // The same among `candidates` only (e.g. UI buttons); every other object lets the ray through
+    ObjectHandle Raycast(const glm::vec3& origin, const glm::vec3& dir, float timeSec,
+        const std::vector<ObjectHandle>& candidates, float* hitDistance = nullptr);
 
     glm::vec3 GetWorldPos(const SceneObject& o, float t) const;
     glm::vec3 GetWorldPosByName(const std::string& name, float t) const;
 
+    // Prepare + Submit on the calling thread; the only path that honours SetGpuMotion
     void Render(Camera& camera, float timeSec);
 
+    // CPU half of a frame, no GL calls: edits, culling, sorting and model matrices. May run on
+    // another thread than Submit, as long as the scene is only touched from that thread and no
+    // meshes, textures or shaders are registered meanwhile.
+    void Prepare(RenderSnapshot& frame, const Camera& camera, float timeSec);
+    // GL half, on the context thread: uploads the snapshot's instances and uniforms and draws
+    void Submit(const RenderSnapshot& frame);
+
+    // Off = one draw per object (every batch holds a single instance)
+    void SetInstancing(bool enabled) { instancing = enabled; }
+    void SetFrustumCulling(bool enabled) { culling = enabled; }
+    // Off = cull with a flat SIMD pass over every object instead of the BVH
+    void SetBvhCulling(bool enabled) { bvhCulling = enabled; }
+    // On = the vertex shader animates objects from parameters uploaded once (and again on edits);
+    // per frame only the time and one object index per instance are sent
+    void SetGpuMotion(bool enabled);
+    // On = each run of draws sharing shader, texture and diffuse color goes out as one
+    // glMultiDrawElementsIndirect. Needs GL 4.3; otherwise prints why, stays off and returns false.
+    bool SetIndirectDraw(bool enabled);
+    // On = Render culls in a compute shader and draws the survivors through indirect commands the
+    // GPU filled, animated from GPU motion parameters. Needs GL 4.3; returns false and stays off otherwise.
+    bool SetGpuCulling(bool enabled);
+    // Objects draw the coarsest level of their mesh whose error, projected at the object's view
+    // depth, stays under this many pixels; 0 = always full detail. GPU culling draws full detail.
+    void SetLodThreshold(float pixels) { lodThreshold = pixels; }
+    // On = objects whose mesh has meshlets, that draw at full detail and whose bounds cross a
+    // frustum plane are culled cluster by cluster and drawn as the surviving index ranges, one
+    // object per batch; objects fully inside stay instanced. Not with GPU culling.
+    void SetClusterCulling(bool enabled) { clusterCulling = enabled; }
+    // Also cull clusters facing away from the camera, which takes objects fully inside out of
+    // instancing too. Off by default: nothing culls back faces, so this is only invisible on
+    // closed, consistently wound meshes.
+    void SetClusterConeCulling(bool enabled) { clusterConeCulling = enabled; }
+    // Debug: with GPU culling, read the visible count back each frame (stalls) for the stats
+    void SetGpuCullingReadback(bool enabled) { gpuCullReadback = enabled; }
+    // Culling, bounds refit and matrix evaluation fan out over these workers; nullptr = serial.
+    // GL calls stay on the calling thread.
+    void SetJobSystem(JobSystem* js) { jobs = js; }
+    const RenderStats& GetStats() const { return stats; }
+
     void Shutdown();
 
 private:
-    void LinkVertexLayout(GpuMesh& m);
-    glm::mat4 BuildModelMatrix(const SceneObject& o, float t) const;
+    struct LayoutArena
+    {
+        MeshArena arena;
+        bool instancesLinked = false;
+        bool objectInstances[2] = {};       // instance attributes enabled, per VAO: full, position only
+    };
+
+    unsigned int ArenaFor(const VertexLayout& layout);
+    void LinkInstanceLayout(LayoutArena& a);
+
+    bool ResolveDraw(const SceneObject& o, unsigned int& shader, int& texture, unsigned int& mesh) const;
+    unsigned int SelectLod(const GpuMesh& m, const SceneObject& o, float depth, float pixelsPerUnit) const;
+    void GetWorldBounds(const SceneObject& o, const GpuMesh& m, float t,
+        glm::vec3& center, glm::vec3& extent, float& radius) const;
+
+    glm::mat4 FillFrameUniforms(FrameUniforms& f, const Camera& camera, float t, bool objectIndices) const;
+    void PrepareFrame(RenderSnapshot& frame, const Camera& camera, float t, bool objectIndices);
+    void BuildDrawList(RenderSnapshot& frame, const Camera& camera, const glm::mat4& viewProj, float t);
+    void BuildDrawListFlat(RenderSnapshot& frame, const Camera& camera, const glm::mat4& viewProj, float t);
+    void CullClusters(RenderSnapshot& frame, const Camera& camera, const glm::mat4& viewProj, float t);
+
+    void RebuildBvh(float t);
+    void UpdateBvh(float t);
+    void MarkMoved(size_t object);
+    void ApplyMovedObjects(float t);
+    void RefitBvhObject(uint32_t object, float t);
+    void RefitBvhDynamic(float t);
+    size_t DenseIndex(ObjectHandle h) const;   // ~0 if stale
+    ObjectHandle HandleOf(size_t object) const;
 
     struct ShaderUniforms
     {
-        GLint model = -1;
         GLint tex0 = -1;
-        GLint lightColor = -1;
-        GLint lightPos = -1;
-        GLint camPos = -1;
+        GLint diffuseColor = -1;
+        GLint vertexDecode = -1;
+        bool positionOnly = false;  // no active vertex attribute but aPos: draws from position streams
+    };
+
+    // Commands [first, first + count) of an indirect buffer that share their GL state
+    struct IndirectRun
+    {
+        size_t first = 0;           // into indirectCommands
+        size_t count = 0;
+        unsigned int shader = 0;
+        int texture = -1;
+        glm::vec3 diffuse{ 1.0f };
+        unsigned int arena = 0;
+        MeshVertexState vertexState;
     };
 
     ShaderUniforms GetShaderUniforms(Shader& s);
+    size_t FrameUniformsBytes();
+    bool UploadFrameUniforms(const FrameUniforms& f);
+    bool UploadMotionParams(size_t& uploadBytes);
+    void SetInstanceLayout(bool& enabled, bool objectIndices);
+    bool BindArena(unsigned int arena, bool positionOnly);
+    void ApplyVertexState(unsigned int slot, const MeshVertexState& v);
+    void PointInstanceAttributes(size_t firstInstance);
+    static bool DrawsClusters(const RenderSnapshot& frame, size_t draw);
+    void DrawBatch(const DrawItem& d, const ShaderUniforms& u, size_t firstInstance, size_t instanceCount,
+        const ClusterRun* clusters = nullptr, size_t clusterCount = 0);
+    void SubmitBatches(const RenderSnapshot& frame);
+    void AppendIndirectBatch(uint64_t key, size_t firstInstance, size_t instanceCount, std::vector<IndirectRun>& runs,
+        const ClusterRun* clusters = nullptr, size_t clusterCount = 0);
+    void DrawIndirectRuns(const std::vector<IndirectRun>& runs);
+    void SubmitIndirect(const RenderSnapshot& frame);
+    void BuildGpuCullScene();
+    void RenderGpuCulled(const Camera& camera, float t, size_t motionBytes);
 
 private:
-    std::vector<GpuMesh> meshes;
-    std::unordered_map<std::string, size_t> meshById;
+    // Interned id -> index into meshes / textures / shaderSlots, -1 until registered
+    StringInterner meshIds;
+    StringInterner textureIds;
+    StringInterner shaderIds;
+    std::vector<int> meshOfId;
+    std::vector<int> textureOfId;
+    std::vector<int> shaderOfId;
 
+    std::vector<LayoutArena> arenas;       // vertices and indices of every mesh, one VAO per vertex layout
+    VertexLayout vertexLayout = VertexLayout::Full();
+    std::vector<GpuMesh> meshes;
     std::vector<Texture> textures;
-    std::unordered_map<std::string, size_t> textureById;
+
+    // Dense so iteration stays linear; handles go through slots, which survive swap-and-pop removal
+    struct ObjectSlot
+    {
+        uint32_t object = 0;        // index into objects while alive
+        uint32_t generation = 1;
+    };
 
     std::vector<SceneObject> objects;
+    std::vector<std::string> objectNames;  // parallel to objects
+    TransformStore transforms;             // parallel to objects, SoA by Motion
+    std::vector<uint32_t> objectSlot;      // objects index -> slot
+    std::vector<ObjectSlot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::unordered_map<std::string, ObjectHandle> objectByName;
 
-    std::unordered_map<std::string, Shader*> shaderById;
-    std::unordered_map<GLuint, ShaderUniforms> uniformsByProgram;
+    std::vector<Shader*> shaderSlots;
+    std::vector<ShaderUniforms> uniformsBySlot;
+    std::vector<VertexDecode> decodeBySlot;    // vertexDecode each program currently holds
 
     glm::vec4 lightColor{ 1,1,1,1 };
     glm::vec3 lightPos{ 0.5f,0.5f,0.5f };
+
+    // Per-frame instance data and uniform block, in slices of a fenced, persistently mapped ring
+    StreamRing stream;
+    size_t instanceOffset = 0;             // of this frame's instance data in the bound array buffer
+    GLint uniformAlignment = 0;            // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, 0 until queried
+    RenderSnapshot renderFrame;            // Render's own frame
+    std::vector<DrawItem> drawScratch;     // radix sort ping-pong buffer
+
+    // World bounds of the draw candidates, SoA for the SIMD frustum test
+    struct CullScratch
+    {
+        std::vector<float> cx, cy, cz, radius, ex, ey, ez;
+        std::vector<uint8_t> resolved;     // has a mesh and shader, i.e. is a draw candidate
+        std::vector<uint8_t> visible;
+    };
+    CullScratch cull;
+
+    // Rebuilt when objects or meshes are added, otherwise refit for moving and touched objects
+    SceneBvh bvh;
+    bool bvhDirty = true;
+    float bvhTime = 0.0f;
+    std::vector<uint32_t> bvhDynamic;      // objects with a Motion
+    std::vector<uint32_t> movedObjects;    // handed out by GetObject/FindObject since the last update
+    std::vector<uint8_t> movedFlag;
+    std::vector<uint32_t> bvhVisible;
+    std::vector<SceneBvh::Item> bvhRefit;  // new bounds of bvhDynamic, computed in parallel
+
+    // GPU motion: per-object parameters in a buffer texture, indexed like objects
+    GLuint motionBuffer = 0;
+    GLuint motionTexture = 0;
+    GLint maxMotionTexels = 0;
+    bool motionParamsDirty = true;         // objects added or removed: upload everything
+    bool motionLimitReported = false;
+    std::vector<uint32_t> motionEdits;     // objects edited since the last upload
+
+    // Multi-draw indirect: one command per submesh draw, cut into runs that need no state change in between
+    GLuint indirectBuffer = 0;
+    std::vector<DrawElementsIndirectCommand> indirectCommands;
+    std::vector<IndirectRun> indirectRuns;
+
+    // glMultiDrawElementsBaseVertex arguments for one submesh's surviving cluster ranges
+    std::vector<GLsizei> clusterCounts;
+    std::vector<const void*> clusterOffsets;
+    std::vector<GLint> clusterBaseVertices;
+
+    // GPU culling: groups and commands rebuilt when objects, meshes, textures or shaders change
+    GpuCuller gpuCuller;
+    std::vector<uint64_t> gpuCullKeys;     // per object, the draw key (depth 0) its group was built for
+    std::vector<IndirectRun> gpuCullRuns;
+    unsigned int gpuCullGroups = 0;
+    bool gpuCullDirty = true;
+    bool gpuCullReadback = false;
+
+    float lodThreshold = 1.0f;             // pixels
+    bool clusterCulling = true;
+    bool clusterConeCulling = false;
+    bool hasMeshlets = false;              // some mesh has them: Prepare runs CullClusters
+    bool instancing = true;
+    bool culling = true;
+    bool bvhCulling = true;
+    bool gpuMotion = false;
+    bool indirectDraw = false;
+    bool gpuCulling = false;
+    bool instanceObjects = false;          // this frame streams object indices instead of matrices
+    JobSystem* jobs = nullptr;
+    RenderStats stats;
+
+    // GL state bound by the current Render call, -1 = unknown
+    int boundTexture = -1;
+    GLuint boundVao = 0;
+    bool constantColorSet = false;         // generic color attribute holds constantColor
+    glm::vec3 constantColor{ 0.0f };
 };
@@ -0,0 +1,131 @@
+#include "MeshArena.h"
+#include <algorithm>
+
+static constexpr size_t kMinVertices = 1u << 16;
+static constexpr size_t kMinIndices = 3u << 16;
+
+// New buffer of newBytes holding the first usedBytes of the old one, which is deleted
+static GLuint GrowBuffer(GLuint old, size_t usedBytes, size_t newBytes)
+{
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)newBytes, nullptr, GL_STATIC_DRAW);
+
+    if (old != 0)
+    {
+        if (usedBytes > 0)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, old);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (GLsizeiptr)usedBytes);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &old);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return buffer;
+}
+
+// Attributes 0..3 read the arena VBO; the EBO binding is VAO state too. Re-run after every growth.
+void MeshArena::LinkVertexLayout()
+{
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    layout.LinkAttributes();
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+
+    if (positionVao)
+    {
+        glBindVertexArray(positionVao);
+        glBindBuffer(GL_ARRAY_BUFFER, positionVbo);
+        layout.LinkPositionAttributes();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MeshArena::Reserve(size_t vertices, size_t indices)
+{
+    const size_t vertexBytes = layout.Stride();
+    bool relink = false;
+
+    if (vertices > vertexCapacity)
+    {
+        const size_t capacity = std::max({ vertices, vertexCapacity * 2, kMinVertices });
+        vbo = GrowBuffer(vbo, vertexCount * vertexBytes, capacity * vertexBytes);
+        if (positionVao)
+        {
+            const size_t positionBytes = layout.PositionStride();
+            positionVbo = GrowBuffer(positionVbo, vertexCount * positionBytes, capacity * positionBytes);
+        }
+        vertexCapacity = capacity;
+        relink = true;
+    }
+
+    if (indices > indexCapacity)
+    {
+        const size_t capacity = std::max({ indices, indexCapacity * 2, kMinIndices });
+        ebo = GrowBuffer(ebo, indexCount * sizeof(GLuint), capacity * sizeof(GLuint));
+        indexCapacity = capacity;
+        relink = true;
+    }
+
+    if (relink)
+        LinkVertexLayout();
+}
+
+MeshArena::Range MeshArena::Add(const void* vertexData, const void* positionData, size_t vertices,
+    const GLuint* indexData, size_t indices)
+{
+    if (vao == 0)
+    {
+        glGenVertexArrays(1, &vao);
+        if (layout.positionStream)
+            glGenVertexArrays(1, &positionVao);
+    }
+
+    Reserve(vertexCount + vertices, indexCount + indices);
+
+    Range r;
+    r.baseVertex = (GLint)vertexCount;
+    r.firstIndex = (GLuint)indexCount;
+
+    // Uploads go through the copy target so no VAO's element binding is touched
+    const size_t vertexBytes = layout.Stride();
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)(vertexCount * vertexBytes), (GLsizeiptr)(vertices * vertexBytes), vertexData);
+    if (positionVao)
+    {
+        const size_t positionBytes = layout.PositionStride();
+        glBindBuffer(GL_COPY_WRITE_BUFFER, positionVbo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)(vertexCount * positionBytes), (GLsizeiptr)(vertices * positionBytes), positionData);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)(indexCount * sizeof(GLuint)), (GLsizeiptr)(indices * sizeof(GLuint)), indexData);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    vertexCount += vertices;
+    indexCount += indices;
+    return r;
+}
+
+size_t MeshArena::CapacityBytes() const
+{
+    const size_t positionBytes = positionVao ? layout.PositionStride() : 0;
+    return vertexCapacity * (layout.Stride() + positionBytes) + indexCapacity * sizeof(GLuint);
+}
+
+void MeshArena::Delete()
+{
+    if (vao) glDeleteVertexArrays(1, &vao);
+    if (vbo) glDeleteBuffers(1, &vbo);
+    if (ebo) glDeleteBuffers(1, &ebo);
+    if (positionVao) glDeleteVertexArrays(1, &positionVao);
+    if (positionVbo) glDeleteBuffers(1, &positionVbo);
+    *this = MeshArena(layout);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <glad/glad.h>
+
+#include "VertexLayout.h"
+
+// One VBO/EBO pair the static meshes of one vertex layout are sub-allocated from, plus the VAO
+// for that layout. Meshes are drawn with a base vertex and an index offset, so switching meshes
+// needs no binds. Append-only; full buffers double with a GPU-side copy. Layouts with a position
+// stream keep it in a third buffer, with a second VAO reading only that and the same indices.
+class MeshArena
+{
+public:
+    explicit MeshArena(const VertexLayout& layout = VertexLayout::Full()) : layout(layout) {}
+
+    struct Range
+    {
+        GLint baseVertex = 0;       // added to every index of the mesh
+        GLuint firstIndex = 0;      // into the shared EBO
+    };
+
+    // Copies a mesh in, vertexData already packed in Layout() and positionData by PackPositions
+    // (only read with a position stream); indices are relative to its first vertex. Creates the
+    // VAOs on first use.
+    Range Add(const void* vertexData, const void* positionData, size_t vertices, const GLuint* indexData, size_t indices);
+
+    const VertexLayout& Layout() const { return layout; }
+    GLuint Vao() const { return vao; }
+    GLuint PositionVao() const { return positionVao; }     // 0 without a position stream
+    size_t VertexCount() const { return vertexCount; }
+    size_t IndexCount() const { return indexCount; }
+    size_t CapacityBytes() const;
+
+    void Delete();
+
+private:
+    void Reserve(size_t vertices, size_t indices);
+    void LinkVertexLayout();
+
+    VertexLayout layout;
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint ebo = 0;
+    GLuint positionVao = 0;
+    GLuint positionVbo = 0;
+
+    size_t vertexCount = 0;
+    size_t vertexCapacity = 0;
+    size_t indexCount = 0;
+    size_t indexCapacity = 0;
+};
@@ -0,0 +1,417 @@
+#include "MeshCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+static constexpr char kMagic[4] = { 'O', 'M', 'C', '1' };
+static constexpr uint32_t kVersion = 6;     // 3: meshes are stored after MeshOptimizer, 4: LOD levels, 5: meshlets, 6: mtllib stamps
+static constexpr uint32_t kStrideFloats = 11; // pos3 + color3 + uv2 + normal3
+
+// Keeps the vertex blob 8-byte aligned inside the mapping
+static_assert(sizeof(MeshCacheHeader) % 8 == 0, "MeshCacheHeader must stay 8-byte aligned");
+
+static uint64_t Mix64(uint64_t h)
+{
+    h ^= h >> 33; h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// Word-at-a-time content hash; only used when size matches but mtime does not
+static uint64_t HashBytes(const char* data, size_t size)
+{
+    uint64_t h = 0x9e3779b97f4a7c15ull ^ size;
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t w;
+        std::memcpy(&w, data + i, 8);
+        h = Mix64(h ^ w) + i;
+    }
+
+    uint64_t tail = 0;
+    std::memcpy(&tail, data + i, size - i);
+    return Mix64(h ^ tail);
+}
+
+static bool StatSource(const std::string& path, uint64_t& size, int64_t& mtime)
+{
+    std::error_code ec;
+    size = (uint64_t)std::filesystem::file_size(path, ec);
+    if (ec) return false;
+
+    const auto t = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+
+    mtime = (int64_t)t.time_since_epoch().count();
+    return true;
+}
+
+static constexpr uint64_t kMissingFile = ~0ull;  // dependency size of a file that did not exist
+
+// Size, mtime and content hash of a file; size kMissingFile when it does not exist
+static void StampFile(const std::string& path, uint64_t& size, int64_t& mtime, uint64_t& hash)
+{
+    hash = 0;
+    if (!StatSource(path, size, mtime))
+    {
+        size = kMissingFile;
+        mtime = 0;
+        return;
+    }
+
+    MappedFile f;
+    if (f.Open(path)) hash = HashBytes(f.Data(), f.Size());
+}
+
+// Whether path is still the file stamped: same size, and same mtime or else same contents
+static bool StampMatches(const std::string& path, uint64_t size, int64_t mtime, uint64_t hash)
+{
+    uint64_t nowSize = 0;
+    int64_t nowMtime = 0;
+    if (!StatSource(path, nowSize, nowMtime)) return size == kMissingFile;
+    if (nowSize != size) return false;
+
+    // Touched but possibly unchanged (checkout, copy): fall back to the content hash
+    if (nowMtime == mtime) return true;
+    MappedFile f;
+    return f.Open(path) && HashBytes(f.Data(), f.Size()) == hash;
+}
+
+static void PutU32(std::string& dst, uint32_t v)
+{
+    dst.append((const char*)&v, sizeof(v));
+}
+
+static void PutString(std::string& dst, const std::string& s)
+{
+    PutU32(dst, (uint32_t)s.size());
+    dst.append(s);
+}
+
+static void PutU64(std::string& dst, uint64_t v)
+{
+    dst.append((const char*)&v, sizeof(v));
+}
+
+static bool GetU32(const char*& p, const char* end, uint32_t& v)
+{
+    if (end - p < (ptrdiff_t)sizeof(v)) return false;
+    std::memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return true;
+}
+
+static bool GetU64(const char*& p, const char* end, uint64_t& v)
+{
+    if (end - p < (ptrdiff_t)sizeof(v)) return false;
+    std::memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return true;
+}
+
+static bool GetString(const char*& p, const char* end, std::string& s)
+{
+    uint32_t len = 0;
+    if (!GetU32(p, end, len) || end - p < (ptrdiff_t)len) return false;
+    s.assign(p, len);
+    p += len;
+    return true;
+}
+
+static void PutSubmeshes(std::string& dst, const std::vector<SubMesh>& submeshes)
+{
+    PutU32(dst, (uint32_t)submeshes.size());
+    for (const SubMesh& s : submeshes)
+    {
+        PutU32(dst, s.material);
+        PutU32(dst, s.indexOffset);
+        PutU32(dst, (uint32_t)s.indexCount);
+    }
+}
+
+// A count read from the file, rejected if the rest of the tail cannot hold that many records of at
+// least recordBytes each, so a corrupt count never turns into a huge allocation
+static bool GetCount(const char*& p, const char* end, size_t recordBytes, uint32_t& count)
+{
+    return GetU32(p, end, count) && (size_t)count <= (size_t)(end - p) / recordBytes;
+}
+
+static bool GetSubmeshes(const char*& p, const char* end, std::vector<SubMesh>& submeshes)
+{
+    uint32_t count = 0;
+    if (!GetCount(p, end, 3 * sizeof(uint32_t), count)) return false;
+
+    submeshes.resize(count);
+    for (SubMesh& s : submeshes)
+    {
+        uint32_t indexCount = 0;
+        if (!GetU32(p, end, s.material) || !GetU32(p, end, s.indexOffset) || !GetU32(p, end, indexCount))
+            return false;
+        s.indexCount = (GLsizei)indexCount;
+    }
+    return true;
+}
+
+// Tail: materialCount, { diffuse rgb, name, diffuseMap }*, submeshes, lodCount, { error, submeshes }*,
+// meshletCount, { offset, count, submesh, center xyz, radius, cone axis xyz, cone cutoff }*
+// where submeshes = count, { material, offset, count }*
+static std::string BuildTail(const CpuMeshData& data)
+{
+    std::string tail;
+
+    PutU32(tail, (uint32_t)data.materials.size());
+    for (const MeshMaterial& m : data.materials)
+    {
+        tail.append((const char*)&m.diffuse.x, 3 * sizeof(float));
+        PutString(tail, m.name);
+        PutString(tail, m.diffuseMap);
+    }
+
+    PutSubmeshes(tail, data.submeshes);
+
+    PutU32(tail, (uint32_t)data.lods.size());
+    for (const MeshLod& lod : data.lods)
+    {
+        tail.append((const char*)&lod.error, sizeof(float));
+        PutSubmeshes(tail, lod.submeshes);
+    }
+
+    PutU32(tail, (uint32_t)data.meshlets.size());
+    for (const Meshlet& m : data.meshlets)
+    {
+        PutU32(tail, m.indexOffset);
+        PutU32(tail, (uint32_t)m.indexCount);
+        PutU32(tail, m.submesh);
+        tail.append((const char*)&m.center.x, 3 * sizeof(float));
+        tail.append((const char*)&m.radius, sizeof(float));
+        tail.append((const char*)&m.coneAxis.x, 3 * sizeof(float));
+        tail.append((const char*)&m.coneCutoff, sizeof(float));
+    }
+
+    return tail;
+}
+
+// Dependencies: { size, mtime, hash, path }* for every material library, zero-padded to 8 bytes
+static std::string BuildDependencies(const CpuMeshData& data)
+{
+    std::string deps;
+    for (const std::string& lib : data.materialLibs)
+    {
+        uint64_t size = 0, hash = 0;
+        int64_t mtime = 0;
+        StampFile(lib, size, mtime, hash);
+
+        PutU64(deps, size);
+        PutU64(deps, (uint64_t)mtime);
+        PutU64(deps, hash);
+        PutString(deps, lib);
+    }
+    deps.resize((deps.size() + 7) & ~size_t(7), '\0');
+    return deps;
+}
+
+static bool DependenciesMatch(const char* p, const char* end, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint64_t size = 0, mtime = 0, hash = 0;
+        std::string path;
+        if (!GetU64(p, end, size) || !GetU64(p, end, mtime) || !GetU64(p, end, hash) || !GetString(p, end, path))
+            return false;
+        if (!StampMatches(path, size, (int64_t)mtime, hash)) return false;
+    }
+    return true;
+}
+
+std::string MeshCache::CachePathFor(const std::string& sourcePath)
+{
+    return sourcePath + ".meshcache";
+}
+
+bool MeshCache::Write(const std::string& sourcePath, const CpuMeshData& data)
+{
+    MappedFile source;
+    if (!source.Open(sourcePath)) return false;
+
+    MeshCacheHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.sourceHash = HashBytes(source.Data(), source.Size());
+    h.strideFloats = kStrideFloats;
+    h.vertexFloatCount = data.vertices.size();
+    h.indexCount = data.indices.size();
+
+    const std::string deps = BuildDependencies(data);
+    h.dependencyCount = (uint32_t)data.materialLibs.size();
+    h.dependencyBytes = (uint32_t)deps.size();
+
+    const std::string tail = BuildTail(data);
+    h.tailBytes = (uint32_t)tail.size();
+
+    if (!StatSource(sourcePath, h.sourceSize, h.sourceMtime)) return false;
+
+    // Write to a temp file first so a crash never leaves a torn cache behind
+    const std::string cachePath = CachePathFor(sourcePath);
+    const std::string tmpPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            std::cout << "Mesh cache write failed: " << cachePath << "\n";
+            return false;
+        }
+
+        out.write((const char*)&h, sizeof(h));
+        out.write(deps.data(), deps.size());
+        out.write((const char*)data.vertices.data(), data.vertices.size() * sizeof(float));
+        out.write((const char*)data.indices.data(), data.indices.size() * sizeof(GLuint));
+        out.write(tail.data(), tail.size());
+        if (!out) return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, cachePath, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+
+    return true;
+}
+
+bool MeshCache::Open(const std::string& sourcePath)
+{
+    Close();
+
+    if (!file.Open(CachePathFor(sourcePath)) || file.Size() < sizeof(MeshCacheHeader))
+    {
+        Close();
+        return false;
+    }
+
+    const auto* h = (const MeshCacheHeader*)file.Data();
+
+    const bool headerOk = std::memcmp(h->magic, kMagic, sizeof(kMagic)) == 0
+        && h->version == kVersion
+        && h->strideFloats == kStrideFloats
+        && h->dependencyBytes % 8 == 0
+        && file.Size() == sizeof(MeshCacheHeader) + h->dependencyBytes + h->vertexFloatCount * sizeof(float)
+            + h->indexCount * sizeof(GLuint) + h->tailBytes;
+
+    const char* deps = file.Data() + sizeof(MeshCacheHeader);
+    if (!headerOk || !StampMatches(sourcePath, h->sourceSize, h->sourceMtime, h->sourceHash)
+        || !DependenciesMatch(deps, deps + h->dependencyBytes, h->dependencyCount))
+    {
+        Close();
+        return false;
+    }
+
+    header = h;
+    vertices = (const float*)(deps + h->dependencyBytes);
+    indices = (const GLuint*)(vertices + h->vertexFloatCount);
+
+    if (!ReadTail((const char*)(indices + h->indexCount), file.Data() + file.Size()) || !RangesValid())
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool MeshCache::ReadTail(const char* p, const char* end)
+{
+    uint32_t count = 0;
+    if (!GetCount(p, end, 3 * sizeof(float) + 2 * sizeof(uint32_t), count)) return false;
+
+    materials.resize(count);
+    for (MeshMaterial& m : materials)
+    {
+        if (end - p < (ptrdiff_t)(3 * sizeof(float))) return false;
+        std::memcpy(&m.diffuse.x, p, 3 * sizeof(float));
+        p += 3 * sizeof(float);
+
+        if (!GetString(p, end, m.name) || !GetString(p, end, m.diffuseMap)) return false;
+    }
+
+    if (!GetSubmeshes(p, end, submeshes) || !GetCount(p, end, sizeof(float) + sizeof(uint32_t), count)) return false;
+
+    lods.resize(count);
+    for (MeshLod& lod : lods)
+    {
+        if (end - p < (ptrdiff_t)sizeof(float)) return false;
+        std::memcpy(&lod.error, p, sizeof(float));
+        p += sizeof(float);
+
+        if (!GetSubmeshes(p, end, lod.submeshes)) return false;
+    }
+
+    if (!GetCount(p, end, 3 * sizeof(uint32_t) + 8 * sizeof(float), count)) return false;
+
+    meshlets.resize(count);
+    for (Meshlet& m : meshlets)
+    {
+        uint32_t indexCount = 0;
+        if (!GetU32(p, end, m.indexOffset) || !GetU32(p, end, indexCount) || !GetU32(p, end, m.submesh))
+            return false;
+        m.indexCount = (GLsizei)indexCount;
+
+        if (end - p < (ptrdiff_t)(8 * sizeof(float))) return false;
+        std::memcpy(&m.center.x, p, 3 * sizeof(float));
+        std::memcpy(&m.radius, p + 3 * sizeof(float), sizeof(float));
+        std::memcpy(&m.coneAxis.x, p + 4 * sizeof(float), 3 * sizeof(float));
+        std::memcpy(&m.coneCutoff, p + 7 * sizeof(float), sizeof(float));
+        p += 8 * sizeof(float);
+    }
+
+    return p == end;
+}
+
+// Everything AddMesh will hand to GL stays inside the blob: vertex indices below the vertex count,
+// index ranges inside the indices, materials and submeshes that exist
+bool MeshCache::RangesValid() const
+{
+    if (header->vertexFloatCount % kStrideFloats != 0) return false;
+
+    const uint64_t vertexCount = header->vertexFloatCount / kStrideFloats;
+    for (uint64_t i = 0; i < header->indexCount; i++)
+        if (indices[i] >= vertexCount) return false;
+
+    auto rangeOk = [&](GLuint offset, GLsizei count)
+    {
+        return count >= 0 && (uint64_t)offset + (uint64_t)count <= header->indexCount;
+    };
+    auto submeshesOk = [&](const std::vector<SubMesh>& list)
+    {
+        for (const SubMesh& s : list)
+            if (!rangeOk(s.indexOffset, s.indexCount) || s.material >= materials.size())
+                return false;
+        return true;
+    };
+
+    if (!submeshesOk(submeshes)) return false;
+    for (const MeshLod& lod : lods)
+        if (!submeshesOk(lod.submeshes)) return false;
+    for (const Meshlet& m : meshlets)
+        if (!rangeOk(m.indexOffset, m.indexCount) || m.submesh >= submeshes.size()) return false;
+
+    return true;
+}
+
+void MeshCache::Close()
+{
+    file.Close();
+    header = nullptr;
+    vertices = nullptr;
+    indices = nullptr;
+    materials.clear();
+    submeshes.clear();
+    lods.clear();
+    meshlets.clear();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Mesh.h"   // CpuMeshData, MeshMaterial, SubMesh, MeshLod, Meshlet
+
+// On-disk blob: header, the files the mesh depends on besides its source (its mtllibs),
+// interleaved 11-float vertices, GLuint indices, then a small tail with the materials,
+// submesh ranges, LOD levels and meshlets
+struct MeshCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    uint64_t sourceHash;
+    uint32_t strideFloats;
+    uint32_t tailBytes;
+    uint64_t vertexFloatCount;
+    uint64_t indexCount;
+    uint32_t dependencyCount;
+    uint32_t dependencyBytes;   // padded to 8, so the vertices stay aligned
+};
+
+// Binary cache of an imported mesh, stored next to its source as "<source>.meshcache".
+// A hit maps the blob and exposes it in place, so it can go straight to the GPU.
+class MeshCache
+{
+public:
+    static std::string CachePathFor(const std::string& sourcePath);
+    static bool Write(const std::string& sourcePath, const CpuMeshData& data);
+
+    // Maps the cache if it exists and still matches sourcePath and every material library it
+    // was built from (size + mtime, or content hash; a library that appeared or vanished misses)
+    bool Open(const std::string& sourcePath);
+    void Close();
+
+    const float* Vertices() const { return vertices; }
+    size_t VertexFloatCount() const { return header ? (size_t)header->vertexFloatCount : 0; }
+
+    const GLuint* Indices() const { return indices; }
+    size_t IndexCount() const { return header ? (size_t)header->indexCount : 0; }
+
+    const std::vector<MeshMaterial>& Materials() const { return materials; }
+    const std::vector<SubMesh>& Submeshes() const { return submeshes; }
+    const std::vector<MeshLod>& Lods() const { return lods; }
+    const std::vector<Meshlet>& Meshlets() const { return meshlets; }
+
+private:
+    bool ReadTail(const char* p, const char* end);
+    bool RangesValid() const;
+
+    MappedFile file;
+    const MeshCacheHeader* header = nullptr;
+    const float* vertices = nullptr;
+    const GLuint* indices = nullptr;
+
+    std::vector<MeshMaterial> materials;
+    std::vector<SubMesh> submeshes;
+    std::vector<MeshLod> lods;
+    std::vector<Meshlet> meshlets;
+};
@@ -0,0 +1,412 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+static constexpr size_t kVertexFloats = 11;     // pos3 + color3 + uv2 + normal3
+
+// Forsyth, "Linear-Speed Vertex Cache Optimisation": vertices score by their position in a
+// modelled LRU cache and by how few triangles still use them; the best scoring triangle among
+// those touching the cache goes next
+static constexpr int kForsythCacheSize = 32;
+static constexpr float kCacheDecayPower = 1.5f;
+static constexpr float kLastTriScore = 0.75f;
+static constexpr float kValenceBoostScale = 2.0f;
+static constexpr float kValenceBoostPower = 0.5f;
+static constexpr unsigned int kMaxValenceScored = 32;  // higher valences score like this one
+
+static constexpr GLuint kNone = ~0u;
+
+struct ForsythScores
+{
+    float cache[kForsythCacheSize];
+    float valence[kMaxValenceScored + 1];
+
+    ForsythScores()
+    {
+        for (int i = 0; i < kForsythCacheSize; i++)
+        {
+            // The last triangle's three vertices score the same whatever their order
+            if (i < 3) cache[i] = kLastTriScore;
+            else cache[i] = std::pow(1.0f - float(i - 3) / float(kForsythCacheSize - 3), kCacheDecayPower);
+        }
+
+        valence[0] = 0.0f;
+        for (unsigned int i = 1; i <= kMaxValenceScored; i++)
+            valence[i] = kValenceBoostScale * std::pow(float(i), -kValenceBoostPower);
+    }
+
+    float Vertex(int cachePos, unsigned int remaining) const
+    {
+        if (remaining == 0) return -1.0f;
+
+        const float c = cachePos >= 0 ? cache[cachePos] : 0.0f;
+        return c + valence[std::min(remaining, kMaxValenceScored)];
+    }
+};
+
+// FIFO cache model: v is cached while fewer than cacheSize misses happened since it was loaded
+struct FifoCache
+{
+    std::vector<unsigned int> loadedAt;
+    unsigned int time;
+    unsigned int size;
+
+    FifoCache(size_t vertexCount, unsigned int cacheSize)
+        : loadedAt(vertexCount, 0), time(cacheSize + 1), size(cacheSize)
+    {
+    }
+
+    unsigned int Touch(GLuint v)
+    {
+        if (time - loadedAt[v] <= size) return 0;
+        loadedAt[v] = time++;
+        return 1;
+    }
+
+    unsigned int Triangle(const GLuint* t) { return Touch(t[0]) + Touch(t[1]) + Touch(t[2]); }
+
+    // Everything loaded so far is evicted
+    void Flush() { time += size + 1; }
+};
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const GLuint* indices, size_t indexCount, size_t vertexCount,
+    unsigned int cacheSize)
+{
+    VertexCacheStats s;
+    const size_t triangles = indexCount / 3;
+    if (triangles == 0) return s;
+
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<uint8_t> seen(vertexCount, 0);
+    size_t misses = 0, unique = 0;
+
+    for (size_t i = 0; i < triangles * 3; i += 3)
+    {
+        misses += cache.Triangle(indices + i);
+        for (size_t k = 0; k < 3; k++)
+        {
+            unique += seen[indices[i + k]] == 0;
+            seen[indices[i + k]] = 1;
+        }
+    }
+
+    s.acmr = float(misses) / float(triangles);
+    s.atvr = float(misses) / float(unique);
+    return s;
+}
+
+void MeshOptimizer::OptimizeVertexCache(GLuint* indices, size_t indexCount, size_t vertexCount)
+{
+    static const ForsythScores scores;
+    const size_t triangles = indexCount / 3;
+    if (triangles == 0) return;
+
+    // Triangles of each vertex, CSR; the first `remaining` of a vertex's slice are not emitted yet
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangles * 3; i++) remaining[indices[i]]++;
+
+    std::vector<size_t> firstTri(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) firstTri[v + 1] = firstTri[v] + remaining[v];
+
+    std::vector<GLuint> adjacency(triangles * 3);
+    std::vector<unsigned int> filled(vertexCount, 0);
+    for (size_t t = 0; t < triangles; t++)
+        for (size_t k = 0; k < 3; k++)
+        {
+            const GLuint v = indices[t * 3 + k];
+            adjacency[firstTri[v] + filled[v]++] = (GLuint)t;
+        }
+
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) vertexScore[v] = scores.Vertex(-1, remaining[v]);
+
+    std::vector<float> triScore(triangles);
+    std::vector<uint8_t> emitted(triangles, 0);
+    for (size_t t = 0; t < triangles; t++)
+        triScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+    const std::vector<GLuint> source(indices, indices + triangles * 3);
+    std::vector<GLuint> cache, nextCache;
+    cache.reserve(kForsythCacheSize + 3);
+    nextCache.reserve(kForsythCacheSize + 3);
+
+    size_t inputCursor = 0;     // fallback when nothing in the cache has triangles left
+    GLuint best = 0;
+    float bestScore = triScore[0];
+    for (size_t t = 1; t < triangles; t++)
+        if (triScore[t] > bestScore) { bestScore = triScore[t]; best = (GLuint)t; }
+
+    for (size_t out = 0; out < triangles; out++)
+    {
+        if (best == kNone)
+        {
+            while (emitted[inputCursor]) inputCursor++;
+            best = (GLuint)inputCursor;
+        }
+
+        const GLuint* tri = &source[(size_t)best * 3];
+        std::memcpy(indices + out * 3, tri, 3 * sizeof(GLuint));
+        emitted[best] = 1;
+
+        for (size_t k = 0; k < 3; k++)
+        {
+            const GLuint v = tri[k];
+            GLuint* list = &adjacency[firstTri[v]];
+            const unsigned int n = remaining[v];
+            for (unsigned int j = 0; j < n; j++)
+                if (list[j] == best) { std::swap(list[j], list[n - 1]); break; }
+            remaining[v]--;
+        }
+
+        // Emitted vertices move to the front; whatever falls past the modelled size leaves it
+        nextCache.assign(tri, tri + 3);
+        for (GLuint v : cache)
+            if (v != tri[0] && v != tri[1] && v != tri[2]) nextCache.push_back(v);
+
+        for (size_t i = kForsythCacheSize; i < nextCache.size(); i++)
+            vertexScore[nextCache[i]] = scores.Vertex(-1, remaining[nextCache[i]]);
+        if (nextCache.size() > (size_t)kForsythCacheSize) nextCache.resize(kForsythCacheSize);
+        cache.swap(nextCache);
+
+        for (size_t i = 0; i < cache.size(); i++)
+            vertexScore[cache[i]] = scores.Vertex((int)i, remaining[cache[i]]);
+
+        // Only triangles around cached vertices changed score; the best of them goes next
+        best = kNone;
+        bestScore = -1.0f;
+        for (GLuint v : cache)
+        {
+            const GLuint* list = &adjacency[firstTri[v]];
+            for (unsigned int j = 0; j < remaining[v]; j++)
+            {
+                const GLuint t = list[j];
+                const float s = vertexScore[source[t * 3]] + vertexScore[source[t * 3 + 1]] + vertexScore[source[t * 3 + 2]];
+                triScore[t] = s;
+                if (s > bestScore) { bestScore = s; best = t; }
+            }
+        }
+    }
+}
+
+// Shaded fragments per covered pixel of an index range, from the six axis-aligned views: a small
+// software rasterizer with a depth test and no face culling, like the renderer draws. Only the
+// order of the triangles changes the result, so it tells whether a reorder pays off.
+static constexpr int kOverdrawGrid = 64;
+
+static float EstimateOverdraw(const GLuint* indices, size_t indexCount, const float* vertices)
+{
+    glm::vec3 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        const float* p = vertices + (size_t)indices[i] * kVertexFloats;
+        lo = glm::min(lo, glm::vec3(p[0], p[1], p[2]));
+        hi = glm::max(hi, glm::vec3(p[0], p[1], p[2]));
+    }
+    const glm::vec3 extent = glm::max(hi - lo, glm::vec3(1e-6f));
+
+    std::vector<float> depth(kOverdrawGrid * kOverdrawGrid);
+    size_t shaded = 0, covered = 0;
+
+    for (int view = 0; view < 6; view++)
+    {
+        const int axis = view / 2, u = (axis + 1) % 3, v = (axis + 2) % 3;
+        const float sign = view % 2 ? -1.0f : 1.0f;
+        std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::max());
+
+        for (size_t t = 0; t + 2 < indexCount; t += 3)
+        {
+            glm::vec3 s[3];     // grid x, grid y, depth
+            for (int k = 0; k < 3; k++)
+            {
+                const float* p = vertices + (size_t)indices[t + k] * kVertexFloats;
+                s[k] = glm::vec3((p[u] - lo[u]) / extent[u] * kOverdrawGrid, (p[v] - lo[v]) / extent[v] * kOverdrawGrid,
+                    sign * p[axis]);
+            }
+
+            const float area = (s[1].x - s[0].x) * (s[2].y - s[0].y) - (s[2].x - s[0].x) * (s[1].y - s[0].y);
+            if (area == 0.0f) continue;
+
+            const int x0 = std::max(0, (int)std::floor(std::min({ s[0].x, s[1].x, s[2].x })));
+            const int x1 = std::min(kOverdrawGrid - 1, (int)std::ceil(std::max({ s[0].x, s[1].x, s[2].x })));
+            const int y0 = std::max(0, (int)std::floor(std::min({ s[0].y, s[1].y, s[2].y })));
+            const int y1 = std::min(kOverdrawGrid - 1, (int)std::ceil(std::max({ s[0].y, s[1].y, s[2].y })));
+
+            for (int y = y0; y <= y1; y++)
+                for (int x = x0; x <= x1; x++)
+                {
+                    const float px = x + 0.5f, py = y + 0.5f;
+                    const float w0 = ((s[2].x - s[1].x) * (py - s[1].y) - (px - s[1].x) * (s[2].y - s[1].y)) / area;
+                    const float w1 = ((s[0].x - s[2].x) * (py - s[2].y) - (px - s[2].x) * (s[0].y - s[2].y)) / area;
+                    const float w2 = 1.0f - w0 - w1;
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+                    const float z = w0 * s[0].z + w1 * s[1].z + w2 * s[2].z;
+                    float& d = depth[y * kOverdrawGrid + x];
+                    if (z < d)
+                    {
+                        covered += d == std::numeric_limits<float>::max();
+                        d = z;
+                        shaded++;
+                    }
+                }
+        }
+    }
+
+    return covered ? float(shaded) / float(covered) : 1.0f;
+}
+
+void MeshOptimizer::OptimizeOverdraw(GLuint* indices, size_t indexCount, const float* vertices, size_t vertexCount,
+    float threshold)
+{
+    const size_t triangles = indexCount / 3;
+    if (triangles < 2) return;
+
+    // Hard boundaries: a triangle missing all three vertices starts over anyway
+    FifoCache cache(vertexCount, kCacheSize);
+    std::vector<size_t> hard;
+    for (size_t t = 0; t < triangles; t++)
+        if (cache.Triangle(indices + t * 3) == 3 || t == 0) hard.push_back(t);
+    hard.push_back(triangles);
+
+    // Soft boundaries: inside a hard cluster, cut wherever the ACMR so far is within threshold of
+    // the cluster's, so splitting there costs little cache efficiency
+    std::vector<size_t> clusters;
+    for (size_t h = 0; h + 1 < hard.size(); h++)
+    {
+        const size_t begin = hard[h], end = hard[h + 1];
+
+        cache.Flush();
+        size_t clusterMisses = 0;
+        for (size_t t = begin; t < end; t++) clusterMisses += cache.Triangle(indices + t * 3);
+        const float limit = threshold * float(clusterMisses) / float(end - begin);
+
+        cache.Flush();
+        clusters.push_back(begin);
+        size_t start = begin, misses = 0;
+        for (size_t t = begin; t < end; t++)
+        {
+            misses += cache.Triangle(indices + t * 3);
+            if (t + 1 < end && float(misses) / float(t + 1 - start) <= limit)
+            {
+                clusters.push_back(t + 1);
+                start = t + 1;
+                misses = 0;
+                cache.Flush();
+            }
+        }
+    }
+    clusters.push_back(triangles);
+
+    // Outward-facing clusters far from the center occlude the rest from most views: draw them first
+    struct Cluster
+    {
+        size_t begin, end;
+        float sortKey;
+    };
+
+    std::vector<Cluster> order;
+    std::vector<glm::vec3> centroid, normal;
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+
+    for (size_t c = 0; c + 1 < clusters.size(); c++)
+    {
+        glm::vec3 center(0.0f), n(0.0f);
+        float area = 0.0f;
+        for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+        {
+            const float* a = vertices + (size_t)indices[t * 3] * kVertexFloats;
+            const float* b = vertices + (size_t)indices[t * 3 + 1] * kVertexFloats;
+            const float* d = vertices + (size_t)indices[t * 3 + 2] * kVertexFloats;
+            const glm::vec3 p0(a[0], a[1], a[2]), p1(b[0], b[1], b[2]), p2(d[0], d[1], d[2]);
+
+            const glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+            const float triArea = glm::length(cross);
+            center += (p0 + p1 + p2) * (triArea / 3.0f);
+            n += cross;
+            area += triArea;
+        }
+
+        meshCentroid += center;
+        meshArea += area;
+        centroid.push_back(area > 0.0f ? center / area : center);
+        normal.push_back(glm::length(n) > 0.0f ? glm::normalize(n) : n);
+        order.push_back(Cluster{ clusters[c], clusters[c + 1], 0.0f });
+    }
+
+    if (meshArea > 0.0f) meshCentroid /= meshArea;
+    for (size_t c = 0; c < order.size(); c++)
+        order[c].sortKey = glm::dot(centroid[c] - meshCentroid, normal[c]);
+
+    std::stable_sort(order.begin(), order.end(),
+        [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    const std::vector<GLuint> source(indices, indices + triangles * 3);
+    size_t out = 0;
+    for (const Cluster& c : order)
+    {
+        std::memcpy(indices + out, &source[c.begin * 3], (c.end - c.begin) * 3 * sizeof(GLuint));
+        out += (c.end - c.begin) * 3;
+    }
+
+    // The outward-first order only pays off where it beats the cache order it costs: keep it when
+    // the range's ACMR stays within threshold and the estimated overdraw goes down, else undo it
+    const float acmrBefore = AnalyzeVertexCache(source.data(), source.size(), vertexCount).acmr;
+    const float acmrAfter = AnalyzeVertexCache(indices, source.size(), vertexCount).acmr;
+    if (acmrAfter > acmrBefore * threshold ||
+        EstimateOverdraw(indices, source.size(), vertices) >= EstimateOverdraw(source.data(), source.size(), vertices))
+        std::memcpy(indices, source.data(), source.size() * sizeof(GLuint));
+}
+
+size_t MeshOptimizer::OptimizeVertexFetch(float* vertices, size_t vertexCount, GLuint* indices, size_t indexCount)
+{
+    std::vector<GLuint> remap(vertexCount, kNone);
+    GLuint next = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        GLuint& r = remap[indices[i]];
+        if (r == kNone) r = next++;
+        indices[i] = r;
+    }
+
+    const std::vector<float> source(vertices, vertices + vertexCount * kVertexFloats);
+    for (size_t v = 0; v < vertexCount; v++)
+        if (remap[v] != kNone)
+            std::memcpy(vertices + (size_t)remap[v] * kVertexFloats, &source[v * kVertexFloats], kVertexFloats * sizeof(float));
+
+    return next;
+}
+
+MeshOptimizeStats MeshOptimizer::Optimize(CpuMeshData& mesh)
+{
+    MeshOptimizeStats s;
+    const size_t vertexCount = mesh.vertices.size() / kVertexFloats;
+    GLuint* indices = mesh.indices.data();
+    const size_t indexCount = mesh.indices.size();
+
+    s.before = AnalyzeVertexCache(indices, indexCount, vertexCount);
+
+    // Ranges are drawn with their own material, so triangles are reordered within each one
+    std::vector<SubMesh> ranges = mesh.submeshes;
+    if (ranges.empty()) ranges.push_back(SubMesh{ 0, 0, (GLsizei)indexCount });
+
+    for (const SubMesh& r : ranges)
+    {
+        if ((size_t)r.indexOffset + (size_t)r.indexCount > indexCount) continue;
+
+        OptimizeVertexCache(indices + r.indexOffset, (size_t)r.indexCount, vertexCount);
+        OptimizeOverdraw(indices + r.indexOffset, (size_t)r.indexCount, mesh.vertices.data(), vertexCount);
+    }
+
+    const size_t kept = OptimizeVertexFetch(mesh.vertices.data(), vertexCount, indices, indexCount);
+    mesh.vertices.resize(kept * kVertexFloats);
+
+    s.after = AnalyzeVertexCache(indices, indexCount, kept);
+    return s;
+}
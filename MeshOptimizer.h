@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include "Mesh.h"   // CpuMeshData
+
+// Post-transform vertex cache efficiency of an index buffer, simulated with a FIFO cache.
+// ACMR = cache misses per triangle (0.5 is the ideal on big regular meshes, 3 the worst),
+// ATVR = misses per referenced vertex (1 = every vertex transformed once).
+struct VertexCacheStats
+{
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+struct MeshOptimizeStats
+{
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+// Import-time reordering of 11-float meshes: triangles for the vertex cache (Forsyth), then
+// triangle clusters for overdraw (Tipsify-style: split where the cache restarts cheaply, outward
+// facing clusters first, kept only where that lowers overdraw), then vertices in first-use order
+// for fetch locality. Triangles never leave their submesh range, and the set of triangles is unchanged.
+class MeshOptimizer
+{
+public:
+    static constexpr unsigned int kCacheSize = 16;      // FIFO entries for the ACMR/ATVR report
+
+    static VertexCacheStats AnalyzeVertexCache(const GLuint* indices, size_t indexCount, size_t vertexCount,
+        unsigned int cacheSize = kCacheSize);
+
+    static void OptimizeVertexCache(GLuint* indices, size_t indexCount, size_t vertexCount);
+    // Expects cache-optimized indices; threshold = ACMR a cluster, and the whole range, may lose to
+    // the reorder (1.05 = 5%). Left in cache order unless the overdraw estimate improves.
+    static void OptimizeOverdraw(GLuint* indices, size_t indexCount, const float* vertices, size_t vertexCount,
+        float threshold = 1.05f);
+    // Renumbers vertices in first-use order, dropping unreferenced ones; returns the vertex count kept
+    static size_t OptimizeVertexFetch(float* vertices, size_t vertexCount, GLuint* indices, size_t indexCount);
+
+    // All three stages, each submesh on its own
+    static MeshOptimizeStats Optimize(CpuMeshData& mesh);
+};
@@ -0,0 +1,608 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MeshOptimizer.h"
+
+static constexpr size_t kVertexFloats = 11;         // pos3 + color3 + uv2 + normal3
+static constexpr unsigned int kMaxLodLevels = 7;    // LOD bits in MeshSystem's draw key
+static constexpr double kBorderWeight = 10.0;       // of the planes that hold borders and seams in place
+static constexpr size_t kMaxSeamSides = 8;          // open edges at one place joined as a single seam
+static constexpr size_t kGrainTriangles = 16384;    // triangles per job when scoring collapses
+
+static constexpr GLuint kNone = ~0u;
+
+// Sum of weighted squared distances to planes n.p + d = 0: p'Ap + 2b.p + c, plus the weight summed
+struct Quadric
+{
+    double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+    double b0 = 0, b1 = 0, b2 = 0, c = 0;
+    double w = 0;
+
+    void AddPlane(const glm::vec3& n, float d, double weight)
+    {
+        a00 += weight * n.x * n.x; a01 += weight * n.x * n.y; a02 += weight * n.x * n.z;
+        a11 += weight * n.y * n.y; a12 += weight * n.y * n.z; a22 += weight * n.z * n.z;
+        b0 += weight * n.x * d; b1 += weight * n.y * d; b2 += weight * n.z * d;
+        c += weight * d * d;
+        w += weight;
+    }
+
+    void Add(const Quadric& q)
+    {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+        b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c;
+        w += q.w;
+    }
+
+    double Weighted(const glm::vec3& p) const
+    {
+        const double x = p.x, y = p.y, z = p.z;
+        const double e = x * (a00 * x + a01 * y + a02 * z) + y * (a01 * x + a11 * y + a12 * z)
+            + z * (a02 * x + a12 * y + a22 * z) + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return std::max(e, 0.0);
+    }
+};
+
+// Mean squared distance of p to the planes of both quadrics
+static float CollapseError(const Quadric& a, const Quadric& b, const glm::vec3& p)
+{
+    const double w = a.w + b.w;
+    return w > 0.0 ? float((a.Weighted(p) + b.Weighted(p)) / w) : 0.0f;
+}
+
+enum class VertexKind : uint8_t
+{
+    Unused,     // no triangle left
+    Manifold,   // every edge shared by two triangles of one group: collapses anywhere
+    Border,     // on two border edges: collapses along them, with its seam twins
+    Locked,     // corners, non-manifold edges, seams that do not pair up
+};
+
+// Per-pass connectivity of the current triangles
+struct Topology
+{
+    std::vector<uint32_t> firstTri;     // CSR: triangles of v are triList[firstTri[v] .. firstTri[v + 1])
+    std::vector<uint32_t> triList;
+    std::vector<VertexKind> kind;
+    std::vector<GLuint> borderNext;     // 2 per vertex: the other ends of its border edges
+};
+
+static bool IsBorderEdge(const Topology& t, GLuint a, GLuint b)
+{
+    return t.kind[a] == VertexKind::Border && (t.borderNext[2 * a] == b || t.borderNext[2 * a + 1] == b);
+}
+
+static void BuildTopology(Topology& t, const GLuint* indices, size_t triCount, const uint32_t* groups, size_t vertexCount)
+{
+    t.firstTri.assign(vertexCount + 1, 0);
+    for (size_t i = 0; i < triCount * 3; i++)
+        t.firstTri[indices[i] + 1]++;
+    for (size_t v = 0; v < vertexCount; v++)
+        t.firstTri[v + 1] += t.firstTri[v];
+
+    t.triList.resize(triCount * 3);
+    std::vector<uint32_t> fill(t.firstTri.begin(), t.firstTri.end() - 1);
+    for (size_t i = 0; i < triCount * 3; i++)
+        t.triList[fill[indices[i]]++] = uint32_t(i / 3);
+
+    // Undirected edges sorted so each edge's triangles sit together
+    struct EdgeRef
+    {
+        uint64_t key;
+        uint32_t group;
+        bool operator<(const EdgeRef& o) const { return key != o.key ? key < o.key : group < o.group; }
+    };
+
+    std::vector<EdgeRef> edges(triCount * 3);
+    for (size_t tri = 0; tri < triCount; tri++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            const GLuint a = indices[tri * 3 + k], b = indices[tri * 3 + (k + 1) % 3];
+            edges[tri * 3 + k] = EdgeRef{ (uint64_t(std::min(a, b)) << 32) | std::max(a, b), groups[tri] };
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<uint8_t> borderCount(vertexCount, 0), locked(vertexCount, 0);
+    t.borderNext.assign(vertexCount * 2, kNone);
+
+    for (size_t i = 0; i < edges.size(); )
+    {
+        size_t end = i + 1;
+        while (end < edges.size() && edges[end].key == edges[i].key) end++;
+
+        const GLuint a = GLuint(edges[i].key >> 32), b = GLuint(edges[i].key & 0xFFFFFFFFu);
+        const size_t count = end - i;
+
+        if (count > 2)
+        {
+            locked[a] = locked[b] = 1;
+        }
+        else if (count == 1 || edges[i].group != edges[i + 1].group)
+        {
+            for (const GLuint v : { a, b })
+            {
+                const GLuint other = v == a ? b : a;
+                if (borderCount[v] < 2) t.borderNext[2 * v + borderCount[v]] = other;
+                borderCount[v] = uint8_t(std::min(borderCount[v] + 1, 3));
+            }
+        }
+        i = end;
+    }
+
+    t.kind.resize(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        if (t.firstTri[v] == t.firstTri[v + 1]) t.kind[v] = VertexKind::Unused;
+        else if (locked[v]) t.kind[v] = VertexKind::Locked;
+        else if (borderCount[v] == 0) t.kind[v] = VertexKind::Manifold;
+        else if (borderCount[v] == 2) t.kind[v] = VertexKind::Border;
+        else t.kind[v] = VertexKind::Locked;
+    }
+}
+
+// Would moving `from` onto `to` turn any of its remaining triangles over?
+static bool FlipsTriangle(const Topology& t, const GLuint* indices, const std::vector<glm::vec3>& pos, GLuint from, GLuint to)
+{
+    for (uint32_t k = t.firstTri[from]; k < t.firstTri[from + 1]; k++)
+    {
+        const GLuint* tri = indices + size_t(t.triList[k]) * 3;
+        if (tri[0] == to || tri[1] == to || tri[2] == to) continue;     // collapses away
+
+        glm::vec3 p[3], q[3];
+        for (int i = 0; i < 3; i++)
+        {
+            p[i] = pos[tri[i]];
+            q[i] = tri[i] == from ? pos[to] : p[i];
+        }
+
+        const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+        const glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+        if (glm::dot(before, after) <= 0.0f) return true;
+    }
+    return false;
+}
+
+static size_t CountSharedTriangles(const Topology& t, const GLuint* indices, GLuint from, GLuint to)
+{
+    size_t n = 0;
+    for (uint32_t k = t.firstTri[from]; k < t.firstTri[from + 1]; k++)
+    {
+        const GLuint* tri = indices + size_t(t.triList[k]) * 3;
+        if (tri[0] == to || tri[1] == to || tri[2] == to) n++;
+    }
+    return n;
+}
+
+static GLuint FindRoot(std::vector<GLuint>& parent, GLuint v)
+{
+    while (parent[v] != v)
+    {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+// The smaller root wins, so a set is named after its first vertex
+static void Unite(std::vector<GLuint>& parent, GLuint a, GLuint b)
+{
+    a = FindRoot(parent, a);
+    b = FindRoot(parent, b);
+    if (a != b) parent[std::max(a, b)] = std::min(a, b);
+}
+
+// Wedges: vertices at the same position on the same surface, split by UVs, normals or colors. `rep`
+// is the first of each and owns the quadric; `sibling` links them in a ring. A surface is made of
+// index-connected pieces joined at their seams, each seam edge to one piece on the other side, so
+// coincident but unrelated surfaces (stacked copies, double-sided shells) keep rings of their own
+// and a ring holds only the few wedges of one seam.
+static void BuildWedges(const GLuint* indices, size_t triCount, const std::vector<glm::vec3>& pos,
+    std::vector<GLuint>& rep, std::vector<GLuint>& sibling)
+{
+    const size_t vertexCount = pos.size();
+
+    // `place` = the first vertex at each position
+    std::vector<GLuint> order(vertexCount), place(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) order[v] = GLuint(v);
+    std::sort(order.begin(), order.end(), [&](GLuint a, GLuint b)
+    {
+        const glm::vec3& p = pos[a];
+        const glm::vec3& q = pos[b];
+        if (p.x != q.x) return p.x < q.x;
+        if (p.y != q.y) return p.y < q.y;
+        if (p.z != q.z) return p.z < q.z;
+        return a < b;
+    });
+    for (size_t i = 0; i < vertexCount; )
+    {
+        size_t end = i + 1;
+        while (end < vertexCount && pos[order[end]] == pos[order[i]]) end++;
+        for (size_t k = i; k < end; k++) place[order[k]] = order[i];
+        i = end;
+    }
+
+    std::vector<GLuint> surface(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) surface[v] = GLuint(v);
+    for (size_t tri = 0; tri < triCount; tri++)
+    {
+        Unite(surface, indices[tri * 3], indices[tri * 3 + 1]);
+        Unite(surface, indices[tri * 3 + 1], indices[tri * 3 + 2]);
+    }
+
+    // Edges with one triangle in index space, keyed by their positions: a seam has one on each
+    // side, running in opposite directions
+    std::vector<uint64_t> halfEdges(triCount * 3);
+    for (size_t tri = 0; tri < triCount; tri++)
+        for (int k = 0; k < 3; k++)
+        {
+            const GLuint a = indices[tri * 3 + k], b = indices[tri * 3 + (k + 1) % 3];
+            halfEdges[tri * 3 + k] = (uint64_t(std::min(a, b)) << 32) | std::max(a, b);
+        }
+    std::sort(halfEdges.begin(), halfEdges.end());
+
+    struct OpenEdge
+    {
+        uint64_t key;
+        bool forward;
+        GLuint piece;
+        bool operator<(const OpenEdge& o) const
+        {
+            if (key != o.key) return key < o.key;
+            return forward != o.forward ? forward < o.forward : piece < o.piece;
+        }
+    };
+
+    std::vector<OpenEdge> open;
+    for (size_t tri = 0; tri < triCount; tri++)
+        for (int k = 0; k < 3; k++)
+        {
+            const GLuint a = indices[tri * 3 + k], b = indices[tri * 3 + (k + 1) % 3];
+            const uint64_t key = (uint64_t(std::min(a, b)) << 32) | std::max(a, b);
+            const auto range = std::equal_range(halfEdges.begin(), halfEdges.end(), key);
+            if (range.second - range.first != 1 || place[a] == place[b]) continue;
+
+            const GLuint pa = place[a], pb = place[b];
+            open.push_back(OpenEdge{ (uint64_t(std::min(pa, pb)) << 32) | std::max(pa, pb), pa < pb, FindRoot(surface, a) });
+        }
+    std::sort(open.begin(), open.end());
+
+    // The pieces on a seam edge join. Past kMaxSeamSides they are stacked copies rather than one
+    // junction, and pair up in order: the n-th running one way with the n-th running the other, or
+    // with each other where the winding disagrees
+    for (size_t i = 0; i < open.size(); )
+    {
+        size_t mid = i, end = i;
+        while (end < open.size() && open[end].key == open[i].key)
+        {
+            if (!open[end].forward) mid = end + 1;
+            end++;
+        }
+
+        if (end - i <= kMaxSeamSides)
+        {
+            for (size_t k = i + 1; k < end; k++) Unite(surface, open[i].piece, open[k].piece);
+        }
+        else if (mid == i || mid == end)
+        {
+            for (size_t k = i; k + 1 < end; k += 2) Unite(surface, open[k].piece, open[k + 1].piece);
+        }
+        else
+        {
+            for (size_t k = 0; i + k < mid && mid + k < end; k++) Unite(surface, open[i + k].piece, open[mid + k].piece);
+        }
+        i = end;
+    }
+    for (size_t v = 0; v < vertexCount; v++) surface[v] = FindRoot(surface, GLuint(v));
+
+    std::sort(order.begin(), order.end(), [&](GLuint a, GLuint b)
+    {
+        if (place[a] != place[b]) return place[a] < place[b];
+        if (surface[a] != surface[b]) return surface[a] < surface[b];
+        return a < b;
+    });
+
+    rep.resize(vertexCount);
+    sibling.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; )
+    {
+        size_t end = i + 1;
+        while (end < vertexCount && place[order[end]] == place[order[i]] && surface[order[end]] == surface[order[i]]) end++;
+        for (size_t k = i; k < end; k++)
+        {
+            rep[order[k]] = order[i];
+            sibling[order[k]] = order[k + 1 < end ? k + 1 : i];
+        }
+        i = end;
+    }
+}
+
+size_t MeshSimplifier::Simplify(GLuint* indices, size_t indexCount, const float* vertices, size_t vertexCount,
+    size_t targetIndexCount, float targetError, float* resultError, uint32_t* triangleGroups, JobSystem* jobs)
+{
+    size_t triCount = indexCount / 3;
+    if (resultError) *resultError = 0.0f;
+    if (triCount == 0 || vertexCount == 0) return triCount * 3;
+
+    std::vector<uint32_t> ownGroups;
+    if (!triangleGroups)
+    {
+        ownGroups.assign(triCount, 0);
+        triangleGroups = ownGroups.data();
+    }
+
+    // Positions scaled to the unit cube, so errors are relative to the largest extent
+    std::vector<glm::vec3> pos(vertexCount);
+    glm::vec3 lo(vertices[0], vertices[1], vertices[2]), hi = lo;
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        const float* p = vertices + v * kVertexFloats;
+        pos[v] = glm::vec3(p[0], p[1], p[2]);
+        lo = glm::min(lo, pos[v]);
+        hi = glm::max(hi, pos[v]);
+    }
+    const glm::vec3 size = hi - lo;
+    const float extent = std::max(size.x, std::max(size.y, size.z));
+    const float invExtent = extent > 0.0f ? 1.0f / extent : 1.0f;
+    for (glm::vec3& p : pos)
+        p = (p - lo) * invExtent;
+
+    std::vector<GLuint> rep, sibling;
+    BuildWedges(indices, triCount, pos, rep, sibling);
+
+    Topology topo;
+    BuildTopology(topo, indices, triCount, triangleGroups, vertexCount);
+
+    // Triangle planes weighted by area, and planes through every border edge perpendicular to its
+    // triangle so borders and seams keep their shape
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t tri = 0; tri < triCount; tri++)
+    {
+        const GLuint* t = indices + tri * 3;
+        const glm::vec3 n = glm::cross(pos[t[1]] - pos[t[0]], pos[t[2]] - pos[t[0]]);
+        const float len = glm::length(n);
+        if (len == 0.0f) continue;
+
+        const glm::vec3 unit = n / len;
+        const float d = -glm::dot(unit, pos[t[0]]);
+        for (int k = 0; k < 3; k++)
+            quadrics[rep[t[k]]].AddPlane(unit, d, 0.5 * len);
+
+        for (int k = 0; k < 3; k++)
+        {
+            const GLuint a = t[k], b = t[(k + 1) % 3];
+            if (!IsBorderEdge(topo, a, b)) continue;
+
+            const glm::vec3 edge = pos[b] - pos[a];
+            const glm::vec3 side = glm::cross(edge, unit);
+            const float sideLen = glm::length(side);
+            if (sideLen == 0.0f) continue;
+
+            const glm::vec3 sn = side / sideLen;
+            const float sd = -glm::dot(sn, pos[a]);
+            const double weight = kBorderWeight * double(glm::dot(edge, edge));
+            quadrics[rep[a]].AddPlane(sn, sd, weight);
+            quadrics[rep[b]].AddPlane(sn, sd, weight);
+        }
+    }
+
+    struct Collapse
+    {
+        float error;
+        GLuint from, to;
+        bool operator<(const Collapse& o) const { return error < o.error; }
+    };
+
+    const size_t targetTris = targetIndexCount / 3;
+    const float maxError = targetError * targetError;
+    float worst = 0.0f;
+
+    std::vector<Collapse> collapses;
+    std::vector<GLuint> remap(vertexCount);
+    std::vector<uint8_t> locked(vertexCount);
+    std::vector<std::pair<GLuint, GLuint>> wedges;
+
+    // Each pass collapses the cheapest edges it can without two collapses touching the same
+    // triangles, so every error it compares is exact; then the connectivity is rebuilt
+    for (bool first = true; triCount > targetTris; first = false)
+    {
+        if (!first)
+            BuildTopology(topo, indices, triCount, triangleGroups, vertexCount);
+
+        // Scored in a slot per triangle edge and direction, so the list comes out in the same
+        // order whichever thread scored what
+        collapses.assign(triCount * 6, Collapse{ 0.0f, kNone, kNone });
+        ParallelFor(jobs, triCount, kGrainTriangles, [&](size_t begin, size_t end)
+        {
+            for (size_t tri = begin; tri < end; tri++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    const GLuint a = indices[tri * 3 + k], b = indices[tri * 3 + (k + 1) % 3];
+
+                    // Interior edges come up once from each side; keep one
+                    if (a > b && !IsBorderEdge(topo, a, b) && !IsBorderEdge(topo, b, a)) continue;
+
+                    for (int dir = 0; dir < 2; dir++)
+                    {
+                        const GLuint from = dir ? b : a, to = dir ? a : b;
+                        const VertexKind kind = topo.kind[from];
+                        if (kind == VertexKind::Manifold || (kind == VertexKind::Border && IsBorderEdge(topo, from, to)))
+                            collapses[tri * 6 + k * 2 + dir] = Collapse{ CollapseError(quadrics[rep[from]], quadrics[rep[to]], pos[to]), from, to };
+                    }
+                }
+            }
+        });
+        collapses.erase(std::remove_if(collapses.begin(), collapses.end(), [](const Collapse& c) { return c.from == kNone; }),
+            collapses.end());
+        std::sort(collapses.begin(), collapses.end());
+
+        for (size_t v = 0; v < vertexCount; v++) remap[v] = GLuint(v);
+        std::fill(locked.begin(), locked.end(), 0);
+        size_t removed = 0;
+
+        for (const Collapse& c : collapses)
+        {
+            if (c.error > maxError || triCount - removed <= targetTris) break;
+            if (locked[rep[c.from]] || locked[rep[c.to]]) continue;
+
+            // A border vertex takes its twin wedges along, each to the wedge of `to` it shares a border
+            // with. Manifold wedges at the same position belong to a separate surface and stay.
+            wedges.clear();
+            wedges.emplace_back(c.from, c.to);
+            bool paired = true;
+            if (topo.kind[c.from] == VertexKind::Border)
+            {
+                for (GLuint s = sibling[c.from]; s != c.from && paired; s = sibling[s])
+                {
+                    if (s == c.to || topo.kind[s] == VertexKind::Unused || topo.kind[s] == VertexKind::Manifold) continue;
+                    if (topo.kind[s] == VertexKind::Locked)
+                    {
+                        paired = false;
+                        break;
+                    }
+
+                    GLuint target = kNone;
+                    for (int k = 0; k < 2; k++)
+                        if (rep[topo.borderNext[2 * s + k]] == rep[c.to]) target = topo.borderNext[2 * s + k];
+
+                    if (target == kNone) paired = false;
+                    else wedges.emplace_back(s, target);
+                }
+            }
+            if (!paired) continue;
+
+            bool flips = false;
+            for (const auto& w : wedges)
+                flips = flips || FlipsTriangle(topo, indices, pos, w.first, w.second);
+            if (flips) continue;
+
+            for (const auto& w : wedges)
+            {
+                remap[w.first] = w.second;
+                removed += CountSharedTriangles(topo, indices, w.first, w.second);
+
+                // Nothing else around this vertex changes in this pass
+                for (uint32_t k = topo.firstTri[w.first]; k < topo.firstTri[w.first + 1]; k++)
+                {
+                    const GLuint* tri = indices + size_t(topo.triList[k]) * 3;
+                    locked[rep[tri[0]]] = locked[rep[tri[1]]] = locked[rep[tri[2]]] = 1;
+                }
+            }
+
+            quadrics[rep[c.to]].Add(quadrics[rep[c.from]]);
+            worst = std::max(worst, c.error);
+        }
+
+        if (removed == 0) break;
+
+        size_t out = 0;
+        for (size_t tri = 0; tri < triCount; tri++)
+        {
+            const GLuint a = remap[indices[tri * 3]], b = remap[indices[tri * 3 + 1]], c = remap[indices[tri * 3 + 2]];
+            if (a == b || b == c || c == a) continue;
+
+            indices[out * 3] = a;
+            indices[out * 3 + 1] = b;
+            indices[out * 3 + 2] = c;
+            triangleGroups[out] = triangleGroups[tri];
+            out++;
+        }
+
+        // Wedges that swapped places drop nothing: the next pass would find the same collapses
+        if (out == triCount) break;
+        triCount = out;
+    }
+
+    if (resultError) *resultError = std::sqrt(worst);
+    return triCount * 3;
+}
+
+size_t MeshSimplifier::GenerateLods(CpuMeshData& mesh, JobSystem* jobs, const LodSettings& settings)
+{
+    mesh.lods.clear();
+
+    const size_t vertexCount = mesh.vertices.size() / kVertexFloats;
+    if (vertexCount == 0 || mesh.indices.empty()) return 0;
+
+    // Levels are appended after the full mesh, which then needs an explicit range
+    if (mesh.submeshes.empty())
+        mesh.submeshes.push_back(SubMesh{ 0, 0, (GLsizei)mesh.indices.size() });
+
+    // The level being simplified, with the submesh each triangle belongs to
+    std::vector<GLuint> current;
+    std::vector<uint32_t> groups;
+    for (size_t r = 0; r < mesh.submeshes.size(); r++)
+    {
+        const SubMesh& s = mesh.submeshes[r];
+        if ((size_t)s.indexOffset + (size_t)s.indexCount > mesh.indices.size()) continue;
+
+        current.insert(current.end(), mesh.indices.begin() + s.indexOffset, mesh.indices.begin() + s.indexOffset + s.indexCount);
+        groups.resize(current.size() / 3, uint32_t(r));
+    }
+
+    glm::vec3 lo(mesh.vertices[0], mesh.vertices[1], mesh.vertices[2]), hi = lo;
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        const glm::vec3 p(mesh.vertices[v * kVertexFloats], mesh.vertices[v * kVertexFloats + 1], mesh.vertices[v * kVertexFloats + 2]);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+    const glm::vec3 size = hi - lo;
+    const float extent = std::max(size.x, std::max(size.y, size.z));
+
+    // Each level starts from the previous one, so their errors add up
+    float error = 0.0f;
+    const unsigned int levels = std::min(settings.maxLevels, kMaxLodLevels);
+    for (unsigned int level = 0; level < levels; level++)
+    {
+        const size_t previous = current.size() / 3;
+        const size_t target = size_t(float(previous) * settings.triangleRatio) * 3;
+        if (settings.maxError <= error || target == 0) break;
+
+        float levelError = 0.0f;
+        const size_t kept = Simplify(current.data(), current.size(), mesh.vertices.data(), vertexCount,
+            target, settings.maxError - error, &levelError, groups.data(), jobs);
+        current.resize(kept);
+        groups.resize(kept / 3);
+
+        if (kept == 0 || float(kept / 3) > float(previous) * settings.minReduction) break;
+        error += levelError;
+
+        MeshLod lod;
+        lod.error = error * extent;
+
+        // Simplify keeps the triangle order, so each submesh is still one run
+        for (size_t tri = 0; tri < groups.size(); )
+        {
+            size_t end = tri + 1;
+            while (end < groups.size() && groups[end] == groups[tri]) end++;
+
+            SubMesh s;
+            s.material = mesh.submeshes[groups[tri]].material;
+            s.indexOffset = (GLuint)mesh.indices.size();
+            s.indexCount = (GLsizei)((end - tri) * 3);
+            mesh.indices.insert(mesh.indices.end(), current.begin() + tri * 3, current.begin() + end * 3);
+            lod.submeshes.push_back(s);
+            tri = end;
+        }
+
+        // The ranges are disjoint: one job each
+        ParallelFor(jobs, lod.submeshes.size(), 1, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+                MeshOptimizer::OptimizeVertexCache(mesh.indices.data() + lod.submeshes[i].indexOffset,
+                    (size_t)lod.submeshes[i].indexCount, vertexCount);
+        });
+
+        mesh.lods.push_back(std::move(lod));
+    }
+
+    return mesh.lods.size();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Mesh.h"   // CpuMeshData, MeshLod, JobSystem
+
+struct LodSettings
+{
+    unsigned int maxLevels = 4;     // coarser levels after the full mesh; MeshSystem draws at most 7
+    float triangleRatio = 0.5f;     // each level aims for this share of the previous one's triangles
+    float maxError = 0.05f;         // total error a level may reach, relative to the mesh's largest extent
+    float minReduction = 0.85f;     // a level keeping more than this share of the previous one ends the chain
+};
+
+// Edge-collapse simplification driven by quadric error metrics (Garland-Heckbert). Vertices collapse
+// onto neighbouring vertices, never onto new positions, so every level reuses the mesh's vertex buffer
+// and only needs its own indices. Edges with one triangle in index space (open borders, UV and normal
+// seams, material boundaries) only collapse along themselves, and a seam vertex moves together with
+// its twin wedges on the other side.
+class MeshSimplifier
+{
+public:
+    // Simplifies 11-float triangles in place towards targetIndexCount, stopping early once the next
+    // collapse would move the surface further than targetError (relative to the largest extent).
+    // triangleGroups, if given, holds a group per triangle (e.g. its submesh); edges between groups
+    // count as borders, and the groups are compacted along with the triangles.
+    // Collapses are scored on the job system, if given; the result does not depend on it.
+    // Returns the index count kept; resultError gets the largest error reached.
+    static size_t Simplify(GLuint* indices, size_t indexCount, const float* vertices, size_t vertexCount,
+        size_t targetIndexCount, float targetError, float* resultError = nullptr, uint32_t* triangleGroups = nullptr,
+        JobSystem* jobs = nullptr);
+
+    // Replaces mesh.lods with a chain of simplified levels, each built from the one before and each
+    // submesh range reordered for the vertex cache; their indices are appended after the full mesh's.
+    // Levels depend on each other, so jobs only split the work inside one: collapse scoring and the
+    // per-submesh cache reorder. Returns the number of levels.
+    static size_t GenerateLods(CpuMeshData& mesh, JobSystem* jobs = nullptr, const LodSettings& settings = {});
+};
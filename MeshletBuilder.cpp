@@ -0,0 +1,222 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static constexpr size_t kVertexFloats = 11;     // pos3 + color3 + uv2 + normal3
+static constexpr float kMinConeDot = 0.1f;      // below this the cone is too wide to ever cull
+static constexpr size_t kSeedWindow = 256;      // unused triangles searched for the nearest when none touch
+
+static glm::vec3 PositionOf(const CpuMeshData& mesh, GLuint v)
+{
+    const float* p = mesh.vertices.data() + (size_t)v * kVertexFloats;
+    return glm::vec3(p[0], p[1], p[2]);
+}
+
+static void ComputeMeshletBounds(const CpuMeshData& mesh, Meshlet& m)
+{
+    const GLuint* idx = mesh.indices.data() + m.indexOffset;
+
+    glm::vec3 lo = PositionOf(mesh, idx[0]), hi = lo;
+    for (GLsizei i = 1; i < m.indexCount; i++)
+    {
+        const glm::vec3 p = PositionOf(mesh, idx[i]);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+
+    m.center = 0.5f * (lo + hi);
+    float r2 = 0.0f;
+    for (GLsizei i = 0; i < m.indexCount; i++)
+    {
+        const glm::vec3 d = PositionOf(mesh, idx[i]) - m.center;
+        r2 = std::max(r2, glm::dot(d, d));
+    }
+    m.radius = std::sqrt(r2);
+
+    // Axis = mean face normal; the cutoff is the sine of the widest angle any normal makes with it
+    std::vector<glm::vec3> normals;
+    glm::vec3 sum(0.0f);
+    for (GLsizei i = 0; i + 2 < m.indexCount; i += 3)
+    {
+        const glm::vec3 a = PositionOf(mesh, idx[i]);
+        const glm::vec3 n = glm::cross(PositionOf(mesh, idx[i + 1]) - a, PositionOf(mesh, idx[i + 2]) - a);
+        const float len = glm::length(n);
+        if (len == 0.0f) continue;
+
+        normals.push_back(n / len);
+        sum += n / len;
+    }
+
+    m.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    m.coneCutoff = 1.0f;
+
+    const float sumLen = glm::length(sum);
+    if (normals.empty() || sumLen == 0.0f) return;
+
+    const glm::vec3 axis = sum / sumLen;
+    float minDot = 1.0f;
+    for (const glm::vec3& n : normals)
+        minDot = std::min(minDot, glm::dot(axis, n));
+
+    m.coneAxis = axis;
+    if (minDot >= kMinConeDot)
+        m.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+// Distinct vertices of tri that meshlet `id` does not hold yet
+static size_t NewVertices(const GLuint* tri, const std::vector<uint32_t>& seen, uint32_t id)
+{
+    size_t n = 0;
+    for (int k = 0; k < 3; k++)
+        if (seen[tri[k]] != id && std::find(tri, tri + k, tri[k]) == tri + k) n++;
+    return n;
+}
+
+// Rewrites one submesh range as meshlets grown over shared vertices, appending them to mesh.meshlets
+static void BuildRange(CpuMeshData& mesh, const SubMesh& range, unsigned int submesh,
+    std::vector<uint32_t>& seen, uint32_t& id)
+{
+    const GLuint* src = mesh.indices.data() + range.indexOffset;
+    const size_t triCount = (size_t)range.indexCount / 3;
+    const size_t vertexCount = seen.size();
+
+    // Triangles around each vertex (CSR)
+    std::vector<uint32_t> first(vertexCount + 1, 0), adjacency(triCount * 3);
+    for (size_t i = 0; i < triCount * 3; i++) first[src[i] + 1]++;
+    for (size_t v = 0; v < vertexCount; v++) first[v + 1] += first[v];
+    {
+        std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+        for (size_t i = 0; i < triCount * 3; i++) adjacency[fill[src[i]]++] = (uint32_t)(i / 3);
+    }
+
+    std::vector<glm::vec3> centroids(triCount);
+    for (size_t t = 0; t < triCount; t++)
+        centroids[t] = (PositionOf(mesh, src[t * 3]) + PositionOf(mesh, src[t * 3 + 1]) + PositionOf(mesh, src[t * 3 + 2])) / 3.0f;
+
+    std::vector<GLuint> out;
+    out.reserve(triCount * 3);
+    std::vector<char> emitted(triCount, 0);
+    std::vector<GLuint> vertices;
+    size_t seed = 0;
+
+    Meshlet current;
+    current.submesh = submesh;
+    current.indexOffset = range.indexOffset;
+    glm::vec3 centroidSum(0.0f);
+
+    for (size_t done = 0; done < triCount; done++)
+    {
+        // Next: the unused triangle touching the meshlet that adds the fewest vertices, nearest its
+        // centroid on ties; with none (unshared vertices, an island used up), the nearest of the next
+        // few unused ones in file order, which MeshOptimizer left roughly local
+        size_t best = triCount, bestNew = 4;
+        float bestDist = 0.0f;
+        const glm::vec3 centroid = current.indexCount > 0 ? centroidSum / float(current.indexCount / 3) : glm::vec3(0.0f);
+        for (GLuint v : vertices)
+        {
+            for (uint32_t a = first[v]; a < first[v + 1]; a++)
+            {
+                const uint32_t t = adjacency[a];
+                if (emitted[t]) continue;
+
+                const size_t added = NewVertices(src + (size_t)t * 3, seen, id);
+                const glm::vec3 d = centroids[t] - centroid;
+                const float dist = glm::dot(d, d);
+                if (added < bestNew || (added == bestNew && dist < bestDist))
+                {
+                    best = t;
+                    bestNew = added;
+                    bestDist = dist;
+                }
+            }
+        }
+
+        if (best == triCount)
+        {
+            while (emitted[seed]) seed++;
+            best = seed;
+            for (size_t t = seed, scanned = 0; t < triCount && scanned < kSeedWindow && current.indexCount > 0; t++)
+            {
+                if (emitted[t]) continue;
+                scanned++;
+
+                const glm::vec3 d = centroids[t] - centroid;
+                const float dist = glm::dot(d, d);
+                if (t == seed || dist < bestDist)
+                {
+                    best = t;
+                    bestDist = dist;
+                }
+            }
+            bestNew = NewVertices(src + best * 3, seen, id);
+        }
+
+        if (current.indexCount > 0 && ((size_t)current.indexCount / 3 == MeshletBuilder::kMaxTriangles
+            || vertices.size() + bestNew > MeshletBuilder::kMaxVertices))
+        {
+            mesh.meshlets.push_back(current);
+            current.indexOffset += (GLuint)current.indexCount;
+            current.indexCount = 0;
+            centroidSum = glm::vec3(0.0f);
+            vertices.clear();
+            id++;
+        }
+
+        const GLuint* tri = src + best * 3;
+        for (int k = 0; k < 3; k++)
+        {
+            if (seen[tri[k]] != id)
+            {
+                seen[tri[k]] = id;
+                vertices.push_back(tri[k]);
+            }
+            out.push_back(tri[k]);
+        }
+        emitted[best] = 1;
+        centroidSum += centroids[best];
+        current.indexCount += 3;
+    }
+
+    if (current.indexCount > 0)
+    {
+        mesh.meshlets.push_back(current);
+        id++;
+    }
+
+    std::copy(out.begin(), out.end(), mesh.indices.begin() + range.indexOffset);
+}
+
+size_t MeshletBuilder::Build(CpuMeshData& mesh)
+{
+    mesh.meshlets.clear();
+
+    const size_t vertexCount = mesh.vertices.size() / kVertexFloats;
+    if (vertexCount == 0 || mesh.indices.empty()) return 0;
+
+    std::vector<SubMesh> ranges = mesh.submeshes;
+    if (ranges.empty()) ranges.push_back(SubMesh{ 0, 0, (GLsizei)mesh.indices.size() });
+
+    // seen[v] == meshlet id: v is already one of that meshlet's vertices
+    std::vector<uint32_t> seen(vertexCount, ~0u);
+    uint32_t id = 0;
+
+    for (size_t r = 0; r < ranges.size(); r++)
+    {
+        const SubMesh& range = ranges[r];
+        if ((size_t)range.indexOffset + (size_t)range.indexCount > mesh.indices.size() || range.indexCount < 3) continue;
+        BuildRange(mesh, range, (unsigned int)r, seen, id);
+    }
+
+    for (Meshlet& m : mesh.meshlets)
+        ComputeMeshletBounds(mesh, m);
+
+    return mesh.meshlets.size();
+}
+
+bool MeshletBuilder::IsBackfacing(const Meshlet& m, const glm::vec3& eye)
+{
+    const glm::vec3 d = m.center - eye;
+    return glm::dot(d, m.coneAxis) >= m.coneCutoff * glm::length(d) + m.radius;
+}
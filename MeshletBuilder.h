@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include "Mesh.h"   // CpuMeshData, Meshlet
+
+// Splits the full-detail submesh ranges of an 11-float mesh into meshlets, each grown from a seed
+// triangle over shared vertices (fewest new vertices first, then nearest) until either limit is
+// reached. Each range's triangles are rewritten in meshlet order, so a meshlet is just an index
+// range to draw. Bounds are the smallest sphere around the meshlet's AABB center and the normal
+// cone of its triangles (cutoff 1 when they spread past ~84 degrees).
+class MeshletBuilder
+{
+public:
+    static constexpr size_t kMaxVertices = 64;
+    static constexpr size_t kMaxTriangles = 124;
+
+    // Replaces mesh.meshlets; returns their count
+    static size_t Build(CpuMeshData& mesh);
+
+    // Meshoptimizer's apex-free cone test: every triangle of the meshlet faces away from `eye`,
+    // both in the meshlet's space
+    static bool IsBackfacing(const Meshlet& m, const glm::vec3& eye);
+};
@@ -2,7 +2,14 @@
 
 out vec4 FragColor;
 
-uniform vec4 lightColor;
+layout (std140) uniform FrameData	// per frame, see FrameUniforms in Mesh.h
+{
+	mat4 camMatrix;
+	vec4 camPos;		// xyz
+	vec4 lightColor;
+	vec4 lightPos;		// xyz
+	vec4 motionTime;	// x = seconds, y = 1 when ModelMatrix() animates from motionParams
+};
 
 void main()
 {
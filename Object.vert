@@ -2,10 +2,10 @@
 
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 model;
-uniform mat4 camMatrix;
+#include "VertexCommon.glsl"
 
 void main()
 {
-	gl_Position = camMatrix * model * vec4(aPos, 1.0f);
+	vec3 pos = aPos * vertexDecode[0].xyz + vertexDecode[1].xyz;
+	gl_Position = camMatrix * ModelMatrix() * vec4(pos, 1.0f);
 }
\ No newline at end of file
@@ -1,11 +1,22 @@
 #include "ObjectLoader.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
 
 #include <fstream>
 #include <sstream>
 #include <iostream>
-#include <unordered_map>
 #include <vector>
 #include <string>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <thread>
+#include <string_view>
+#include <filesystem>
 
 #include <glm/glm.hpp>
 
@@ -25,17 +36,713 @@ struct ObjVertexKey
     }
 };
 
-struct ObjVertexKeyHash
+// Set through ObjectLoader::SetDedupStats
+static bool gDedupStats = false;
+
+// Flat open-addressing map ObjVertexKey -> vertex index.
+// Linear probing over a power-of-two slot array; reserved at <= 50% load, grown past 70%.
+class ObjVertexTable
+{
+public:
+    static constexpr unsigned int kEmpty = 0xFFFFFFFFu;
+
+    void Reserve(size_t expected)
+    {
+        size_t capacity = 16;
+        while (capacity < expected * 2) capacity <<= 1;
+        if (capacity > slots.size()) Rehash(capacity);
+    }
+
+    // Returns the index stored for key; if absent, stores newIndex and sets inserted
+    unsigned int FindOrInsert(const ObjVertexKey& key, unsigned int newIndex, bool& inserted)
+    {
+        if ((count + 1) * 10 > slots.size() * 7)
+            Rehash(std::max<size_t>(16, slots.size() * 2));
+
+        const size_t mask = slots.size() - 1;
+        size_t i = (size_t)Hash(key) & mask;
+        size_t probe = 0;
+
+        while (slots[i].value != kEmpty && !(slots[i].key == key))
+        {
+            i = (i + 1) & mask;
+            probe++;
+        }
+
+        lookups++;
+        totalProbe += probe;
+        maxProbe = std::max(maxProbe, probe);
+
+        inserted = slots[i].value == kEmpty;
+        if (inserted)
+        {
+            slots[i].key = key;
+            slots[i].value = newIndex;
+            count++;
+        }
+        return slots[i].value;
+    }
+
+    void PrintStats() const
+    {
+        std::cout << "dedup: " << count << " unique / " << lookups << " lookups, capacity " << slots.size()
+            << ", load " << (slots.empty() ? 0.0 : double(count) / double(slots.size()))
+            << ", avg probe " << (lookups ? double(totalProbe) / double(lookups) : 0.0)
+            << ", max probe " << maxProbe << "\n";
+    }
+
+private:
+    struct Slot
+    {
+        ObjVertexKey key;
+        unsigned int value = kEmpty;
+    };
+
+    // v/vt packed into one word, vn folded in, then a murmur3 finalizer so
+    // sequential indices spread over the whole table
+    static uint64_t Hash(const ObjVertexKey& k)
+    {
+        uint64_t h = ((uint64_t)(uint32_t)k.v << 32) | (uint32_t)k.vt;
+        h ^= (uint64_t)(uint32_t)k.vn * 0x9e3779b97f4a7c15ull;
+        h ^= h >> 33; h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    void Rehash(size_t capacity)
+    {
+        std::vector<Slot> old(capacity);
+        old.swap(slots);
+
+        const size_t mask = capacity - 1;
+        for (const Slot& s : old)
+        {
+            if (s.value == kEmpty) continue;
+
+            size_t i = (size_t)Hash(s.key) & mask;
+            while (slots[i].value != kEmpty) i = (i + 1) & mask;
+            slots[i] = s;
+        }
+    }
+
+    std::vector<Slot> slots;
+    size_t count = 0;
+
+    size_t lookups = 0;
+    size_t totalProbe = 0;
+    size_t maxProbe = 0;
+};
+
+static inline void AppendVertex11(std::vector<float>& dst,
+    const glm::vec3& p,
+    const glm::vec2& uv,
+    const glm::vec3& n)
+{
+    // pos
+    dst.push_back(p.x); dst.push_back(p.y); dst.push_back(p.z);
+    // color (default white)
+    dst.push_back(1.0f); dst.push_back(1.0f); dst.push_back(1.0f);
+    // uv
+    dst.push_back(uv.x); dst.push_back(uv.y);
+    // normal
+    dst.push_back(n.x); dst.push_back(n.y); dst.push_back(n.z);
+}
+
+static void LoadMTL(const std::string& path, std::vector<MeshMaterial>& dst);
+
+// Attribute pools + vertex dedup + material ranges shared by both parsing paths
+struct ObjMeshBuilder
 {
-    size_t operator()(const ObjVertexKey& k) const
+    CpuMeshData& out;
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texcoords;
+    std::vector<glm::vec3> normals;
+
+    ObjVertexTable vertexRemap;
+
+    std::filesystem::path baseDir;          // mtllib paths are relative to the .obj
+    std::vector<MeshMaterial> library;      // everything declared by mtllib files
+    std::vector<std::string> loadedLibs;
+
+    // Triangles per used material (out.materials order = first use); joined by Finish
+    std::vector<std::vector<GLuint>> rangeIndices;
+    unsigned int currentMaterial = 0;
+
+    ObjMeshBuilder(CpuMeshData& dst, const std::string& objPath)
+        : out(dst), baseDir(std::filesystem::path(objPath).parent_path())
+    {
+    }
+
+    void MaterialLib(std::string_view file)
+    {
+        const std::string libPath = (baseDir / std::filesystem::path(file)).string();
+        if (std::find(loadedLibs.begin(), loadedLibs.end(), libPath) != loadedLibs.end()) return;
+
+        loadedLibs.push_back(libPath);
+        LoadMTL(libPath, library);
+    }
+
+    void UseMaterial(std::string_view name)
+    {
+        for (size_t i = 0; i < out.materials.size(); i++)
+        {
+            if (out.materials[i].name == name)
+            {
+                currentMaterial = (unsigned int)i;
+                return;
+            }
+        }
+
+        out.materials.emplace_back();
+        out.materials.back().name = name;
+        rangeIndices.emplace_back();
+        currentMaterial = (unsigned int)out.materials.size() - 1;
+    }
+
+    unsigned int GetOrCreateVertexIndex(int vi, int vti, int vni)
+    {
+        // Support negative indices (OBJ spec)
+        if (vi < 0)  vi = (int)positions.size() + 1 + vi;
+        if (vti < 0) vti = (int)texcoords.size() + 1 + vti;
+        if (vni < 0) vni = (int)normals.size() + 1 + vni;
+
+        return GetOrCreateVertexIndex(ObjVertexKey{ vi, vti, vni },
+            (int)positions.size(), (int)texcoords.size(), (int)normals.size());
+    }
+
+    // Key already resolved; nv/nvt/nvn are the attribute counts visible when the face was read
+    unsigned int GetOrCreateVertexIndex(const ObjVertexKey& key, int nv, int nvt, int nvn)
+    {
+        const unsigned int newIndex = (unsigned int)(out.vertices.size() / kVertexStrideFloats);
+
+        bool inserted = false;
+        const unsigned int index = vertexRemap.FindOrInsert(key, newIndex, inserted);
+        if (!inserted)
+            return index;
+
+        glm::vec3 p(0.0f);
+        glm::vec2 uv(0.0f);
+        glm::vec3 n(0.0f, 0.0f, 1.0f);
+
+        if (key.v > 0 && key.v <= nv)    p = positions[key.v - 1];
+        if (key.vt > 0 && key.vt <= nvt) uv = texcoords[key.vt - 1];
+        if (key.vn > 0 && key.vn <= nvn) n = normals[key.vn - 1];
+
+        AppendVertex11(out.vertices, p, uv, n);
+        return newIndex;
+    }
+
+    // Triangulate fan: (0, i, i+1)
+    void EmitFan(const std::vector<unsigned int>& face)
     {
-        size_t h1 = std::hash<int>{}(k.v);
-        size_t h2 = std::hash<int>{}(k.vt);
-        size_t h3 = std::hash<int>{}(k.vn);
-        return (h1 * 73856093u) ^ (h2 * 19349663u) ^ (h3 * 83492791u);
+        // Faces before any usemtl go to an unnamed default material
+        if (out.materials.empty()) UseMaterial("");
+
+        std::vector<GLuint>& dst = rangeIndices[currentMaterial];
+        for (size_t i = 1; i + 1 < face.size(); i++)
+        {
+            dst.push_back(face[0]);
+            dst.push_back(face[i]);
+            dst.push_back(face[i + 1]);
+        }
+    }
+
+    // Lays the material ranges out back to back and resolves material properties
+    void Finish()
+    {
+        std::vector<MeshMaterial> used;
+
+        for (size_t i = 0; i < rangeIndices.size(); i++)
+        {
+            std::vector<GLuint>& range = rangeIndices[i];
+            if (range.empty()) continue;
+
+            MeshMaterial mat = out.materials[i];
+            for (const MeshMaterial& lib : library)
+                if (lib.name == mat.name) { mat = lib; break; }
+
+            out.submeshes.push_back(SubMesh{ (unsigned int)used.size(), (GLuint)out.indices.size(), (GLsizei)range.size() });
+            used.push_back(std::move(mat));
+
+            if (out.indices.empty()) out.indices = std::move(range);
+            else out.indices.insert(out.indices.end(), range.begin(), range.end());
+        }
+
+        out.materials = std::move(used);
+        out.materialLibs = loadedLibs;
     }
 };
 
+static void LogLoaded(const std::string& path, const ObjMeshBuilder& builder)
+{
+    std::cout << "OBJ loaded: " << path << "\n";
+    std::cout << "floats: " << builder.out.vertices.size() << " (stride " << kVertexStrideFloats << ")\n";
+    std::cout << "indices: " << builder.out.indices.size() << "\n";
+    std::cout << "materials: " << builder.out.materials.size() << "\n";
+
+    if (gDedupStats)
+        builder.vertexRemap.PrintStats();
+}
+
+// ------------------------ In-place (mapped) parser ------------------------
+
+static inline bool IsBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline const char* SkipBlanks(const char* p, const char* end)
+{
+    while (p < end && IsBlank(*p)) p++;
+    return p;
+}
+
+static inline const char* TokenEnd(const char* p, const char* end)
+{
+    while (p < end && !IsBlank(*p)) p++;
+    return p;
+}
+
+// Reads the next float on the line; mirrors "ss >> f" (leading '+' allowed)
+static inline bool ParseFloat(const char*& p, const char* end, float& v)
+{
+    p = SkipBlanks(p, end);
+    const char* s = p;
+    if (s < end && *s == '+') s++;
+
+    const auto r = std::from_chars(s, end, v);
+    if (r.ec != std::errc()) return false;
+
+    p = r.ptr;
+    return true;
+}
+
+// Mirrors std::stoi on a token slice: optional sign, digits, trailing junk ignored
+static inline bool ParseIndex(const char* b, const char* e, int& v)
+{
+    if (b < e && *b == '+') b++;
+    return std::from_chars(b, e, v).ec == std::errc();
+}
+
+// Same rules as ParseFaceToken, on a [b, e) slice of the mapped file
+static bool ParseFaceTokenInPlace(const char* b, const char* e, int& vi, int& vti, int& vni)
+{
+    vi = vti = vni = 0;
+
+    const char* p1 = (const char*)std::memchr(b, '/', e - b);
+    if (!p1)
+        return ParseIndex(b, e, vi);
+
+    // v
+    if (p1 != b && !ParseIndex(b, p1, vi)) return false;
+
+    const char* p2 = (const char*)std::memchr(p1 + 1, '/', e - (p1 + 1));
+    if (!p2)
+    {
+        // v/vt
+        if (p1 + 1 != e && !ParseIndex(p1 + 1, e, vti)) return false;
+        return true;
+    }
+
+    // v/vt/vn or v//vn
+    if (p2 != p1 + 1 && !ParseIndex(p1 + 1, p2, vti)) return false;
+    if (p2 + 1 != e && !ParseIndex(p2 + 1, e, vni)) return false;
+    return true;
+}
+
+static inline bool TagIs(const char* b, const char* e, const char* tag, size_t len)
+{
+    return (size_t)(e - b) == len && std::memcmp(b, tag, len) == 0;
+}
+
+// Walks the OBJ lines in [cur, end) and forwards every v/vt/vn/f record to the sink
+template<typename Sink>
+static void ParseObjRange(const char* cur, const char* const end, Sink& sink)
+{
+    while (cur < end)
+    {
+        const char* lineEnd = (const char*)std::memchr(cur, '\n', end - cur);
+        if (!lineEnd) lineEnd = end;
+
+        const char* p = SkipBlanks(cur, lineEnd);
+        const char* tagEnd = TokenEnd(p, lineEnd);
+
+        if (TagIs(p, tagEnd, "v", 1))
+        {
+            glm::vec3 v(0.0f);
+            p = tagEnd;
+            ParseFloat(p, lineEnd, v.x) && ParseFloat(p, lineEnd, v.y) && ParseFloat(p, lineEnd, v.z);
+            sink.Position(v);
+        }
+        else if (TagIs(p, tagEnd, "vt", 2))
+        {
+            // Optional w is ignored, same as the stream parser
+            glm::vec2 uv(0.0f);
+            p = tagEnd;
+            ParseFloat(p, lineEnd, uv.x) && ParseFloat(p, lineEnd, uv.y);
+            sink.Texcoord(uv);
+        }
+        else if (TagIs(p, tagEnd, "vn", 2))
+        {
+            glm::vec3 n(0.0f);
+            p = tagEnd;
+            ParseFloat(p, lineEnd, n.x) && ParseFloat(p, lineEnd, n.y) && ParseFloat(p, lineEnd, n.z);
+            sink.Normal(n);
+        }
+        else if (TagIs(p, tagEnd, "f", 1))
+        {
+            sink.BeginFace();
+
+            for (p = SkipBlanks(tagEnd, lineEnd); p < lineEnd; p = SkipBlanks(p, lineEnd))
+            {
+                const char* tokEnd = TokenEnd(p, lineEnd);
+
+                int vi, vti, vni;
+                if (ParseFaceTokenInPlace(p, tokEnd, vi, vti, vni))
+                    sink.Corner(vi, vti, vni);
+
+                p = tokEnd;
+            }
+
+            sink.EndFace();
+        }
+        else if (TagIs(p, tagEnd, "usemtl", 6))
+        {
+            p = SkipBlanks(tagEnd, lineEnd);
+            sink.UseMaterial(std::string_view(p, TokenEnd(p, lineEnd) - p));
+        }
+        else if (TagIs(p, tagEnd, "mtllib", 6))
+        {
+            for (p = SkipBlanks(tagEnd, lineEnd); p < lineEnd; p = SkipBlanks(p, lineEnd))
+            {
+                const char* tokEnd = TokenEnd(p, lineEnd);
+                sink.MaterialLib(std::string_view(p, tokEnd - p));
+                p = tokEnd;
+            }
+        }
+
+        cur = lineEnd + 1;
+    }
+}
+
+// Material library: newmtl / Kd / map_Kd; other statements are ignored
+static void LoadMTL(const std::string& path, std::vector<MeshMaterial>& dst)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        std::cout << "MTL open failed: " << path << "\n";
+        return;
+    }
+
+    const std::filesystem::path dir = std::filesystem::path(path).parent_path();
+    size_t current = dst.size();    // == dst.size() until the first newmtl
+
+    const char* cur = file.Data();
+    const char* const end = cur + file.Size();
+
+    while (cur < end)
+    {
+        const char* lineEnd = (const char*)std::memchr(cur, '\n', end - cur);
+        if (!lineEnd) lineEnd = end;
+
+        const char* p = SkipBlanks(cur, lineEnd);
+        const char* tagEnd = TokenEnd(p, lineEnd);
+
+        if (TagIs(p, tagEnd, "newmtl", 6))
+        {
+            p = SkipBlanks(tagEnd, lineEnd);
+            current = dst.size();
+            dst.emplace_back();
+            dst[current].name.assign(p, TokenEnd(p, lineEnd));
+        }
+        else if (current < dst.size() && TagIs(p, tagEnd, "Kd", 2))
+        {
+            glm::vec3 kd(1.0f);
+            p = tagEnd;
+            ParseFloat(p, lineEnd, kd.x) && ParseFloat(p, lineEnd, kd.y) && ParseFloat(p, lineEnd, kd.z);
+            dst[current].diffuse = kd;
+        }
+        else if (current < dst.size() && TagIs(p, tagEnd, "map_Kd", 6))
+        {
+            // Options (-s, -o, ...) come first; the file name is the last token
+            const char* last = nullptr;
+            const char* lastEnd = nullptr;
+            for (p = SkipBlanks(tagEnd, lineEnd); p < lineEnd; p = SkipBlanks(p, lineEnd))
+            {
+                last = p;
+                lastEnd = p = TokenEnd(p, lineEnd);
+            }
+
+            if (last)
+                dst[current].diffuseMap = (dir / std::filesystem::path(std::string(last, lastEnd))).string();
+        }
+
+        cur = lineEnd + 1;
+    }
+}
+
+// Single-threaded: records go straight into the builder
+struct ObjSerialSink
+{
+    ObjMeshBuilder& builder;
+    std::vector<unsigned int> face;
+
+    void Position(const glm::vec3& v) { builder.positions.push_back(v); }
+    void Texcoord(const glm::vec2& uv) { builder.texcoords.push_back(uv); }
+    void Normal(const glm::vec3& n) { builder.normals.push_back(n); }
+
+    void BeginFace() { face.clear(); }
+    void Corner(int vi, int vti, int vni) { face.push_back(builder.GetOrCreateVertexIndex(vi, vti, vni)); }
+    void EndFace() { builder.EmitFan(face); }
+
+    void UseMaterial(std::string_view name) { builder.UseMaterial(name); }
+    void MaterialLib(std::string_view file) { builder.MaterialLib(file); }
+};
+
+// ------------------------ Chunked (multithreaded) parse ------------------------
+
+// Below this many bytes per chunk, thread startup costs more than it saves
+static constexpr size_t kMinChunkBytes = 1u << 20;
+
+// Rough OBJ bytes per unique vertex, used to pre-size the dedup table for serial loads
+static constexpr size_t kBytesPerVertexGuess = 64;
+
+struct ObjRecordCounts
+{
+    int v = 0;
+    int vt = 0;
+    int vn = 0;
+};
+
+struct ObjFaceRecord
+{
+    unsigned int cornerCount = 0;
+    ObjRecordCounts visible;        // attribute counts at the point the face was read
+};
+
+struct ObjChunk
+{
+    const char* begin = nullptr;
+    const char* end = nullptr;
+
+    ObjRecordCounts count;          // records inside this chunk
+    ObjRecordCounts base;           // records in all earlier chunks
+
+    std::vector<ObjVertexKey> corners;  // resolved (1-based, absolute) in file order
+    std::vector<ObjFaceRecord> faces;
+
+    // usemtl/mtllib are replayed during the merge; views point into the mapped file
+    std::vector<std::pair<size_t, std::string_view>> materialSwitches;  // (face index, name)
+    std::vector<std::string_view> materialLibs;
+};
+
+// Tag-only scan, used to size the shared attribute arrays before parsing
+static ObjRecordCounts CountObjRecords(const char* cur, const char* const end)
+{
+    ObjRecordCounts c;
+    while (cur < end)
+    {
+        const char* lineEnd = (const char*)std::memchr(cur, '\n', end - cur);
+        if (!lineEnd) lineEnd = end;
+
+        const char* p = SkipBlanks(cur, lineEnd);
+        const char* tagEnd = TokenEnd(p, lineEnd);
+
+        if (TagIs(p, tagEnd, "v", 1)) c.v++;
+        else if (TagIs(p, tagEnd, "vt", 2)) c.vt++;
+        else if (TagIs(p, tagEnd, "vn", 2)) c.vn++;
+
+        cur = lineEnd + 1;
+    }
+    return c;
+}
+
+// Worker side: attributes land at their final slot, faces are resolved but not deduplicated
+struct ObjChunkSink
+{
+    ObjMeshBuilder& builder;
+    ObjChunk& chunk;
+    ObjRecordCounts seen;
+    size_t faceStart = 0;
+
+    void Position(const glm::vec3& v) { builder.positions[seen.v++] = v; }
+    void Texcoord(const glm::vec2& uv) { builder.texcoords[seen.vt++] = uv; }
+    void Normal(const glm::vec3& n) { builder.normals[seen.vn++] = n; }
+
+    void BeginFace() { faceStart = chunk.corners.size(); }
+
+    void Corner(int vi, int vti, int vni)
+    {
+        // Negative indices are relative to what the serial parser would have seen here
+        if (vi < 0)  vi = seen.v + 1 + vi;
+        if (vti < 0) vti = seen.vt + 1 + vti;
+        if (vni < 0) vni = seen.vn + 1 + vni;
+        chunk.corners.push_back(ObjVertexKey{ vi, vti, vni });
+    }
+
+    void EndFace()
+    {
+        chunk.faces.push_back(ObjFaceRecord{ (unsigned int)(chunk.corners.size() - faceStart), seen });
+    }
+
+    void UseMaterial(std::string_view name) { chunk.materialSwitches.emplace_back(chunk.faces.size(), name); }
+    void MaterialLib(std::string_view file) { chunk.materialLibs.push_back(file); }
+};
+
+// Runs fn(i) for i in [0, count), one thread per index (index 0 on the caller)
+template<typename Fn>
+static void RunPerChunk(size_t count, const Fn& fn)
+{
+    std::vector<std::thread> workers;
+    workers.reserve(count - 1);
+    for (size_t i = 1; i < count; i++)
+        workers.emplace_back([&fn, i]() { fn(i); });
+
+    fn(0);
+    for (auto& w : workers) w.join();
+}
+
+static void LoadChunked(const char* data, size_t size, size_t chunkCount, ObjMeshBuilder& builder)
+{
+    // Split at line boundaries
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* const end = data + size;
+    const char* cur = data;
+
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        const char* split = (i + 1 == chunkCount) ? end : std::max(cur, data + size / chunkCount * (i + 1));
+        if (split < end)
+        {
+            const char* nl = (const char*)std::memchr(split, '\n', end - split);
+            split = nl ? nl + 1 : end;
+        }
+
+        chunks[i].begin = cur;
+        chunks[i].end = split;
+        cur = split;
+    }
+
+    RunPerChunk(chunkCount, [&](size_t i) { chunks[i].count = CountObjRecords(chunks[i].begin, chunks[i].end); });
+
+    ObjRecordCounts total;
+    for (auto& c : chunks)
+    {
+        c.base = total;
+        total.v += c.count.v;
+        total.vt += c.count.vt;
+        total.vn += c.count.vn;
+    }
+
+    builder.positions.resize(total.v);
+    builder.texcoords.resize(total.vt);
+    builder.normals.resize(total.vn);
+
+    RunPerChunk(chunkCount, [&](size_t i)
+        {
+            ObjChunkSink sink{ builder, chunks[i], chunks[i].base };
+            ParseObjRange(chunks[i].begin, chunks[i].end, sink);
+        });
+
+    // Unique vertices never exceed the corner count and rarely exceed twice the largest pool
+    size_t totalCorners = 0;
+    for (const auto& c : chunks) totalCorners += c.corners.size();
+    builder.vertexRemap.Reserve(std::min(totalCorners, (size_t)std::max({ total.v, total.vt, total.vn }) * 2));
+
+    // Material libraries only define properties; resolved in Finish, so load order is irrelevant
+    for (const auto& c : chunks)
+        for (std::string_view lib : c.materialLibs)
+            builder.MaterialLib(lib);
+
+    // Deterministic merge: dedup in file order, exactly like the serial path
+    std::vector<unsigned int> face;
+    for (const auto& c : chunks)
+    {
+        const ObjVertexKey* corner = c.corners.data();
+        auto sw = c.materialSwitches.begin();
+
+        for (size_t fi = 0; fi < c.faces.size(); fi++)
+        {
+            const ObjFaceRecord& f = c.faces[fi];
+            for (; sw != c.materialSwitches.end() && sw->first == fi; ++sw)
+                builder.UseMaterial(sw->second);
+
+            face.clear();
+            for (unsigned int k = 0; k < f.cornerCount; k++)
+                face.push_back(builder.GetOrCreateVertexIndex(*corner++, f.visible.v, f.visible.vt, f.visible.vn));
+
+            builder.EmitFan(face);
+        }
+
+        // Trailing usemtl with no faces after it still selects the material for the next chunk
+        for (; sw != c.materialSwitches.end(); ++sw)
+            builder.UseMaterial(sw->second);
+    }
+}
+
+CpuMeshData ObjectLoader::LoadOBJ(const std::string& path, unsigned int threadCount)
+{
+    CpuMeshData out;
+
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        std::cout << "OBJ open failed: " << path << "\n";
+        return out;
+    }
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    const size_t chunkCount = std::min<size_t>(threadCount, file.Size() / kMinChunkBytes);
+
+    ObjMeshBuilder builder(out, path);
+
+    if (chunkCount > 1)
+    {
+        LoadChunked(file.Data(), file.Size(), chunkCount, builder);
+    }
+    else
+    {
+        builder.vertexRemap.Reserve(file.Size() / kBytesPerVertexGuess);
+
+        ObjSerialSink sink{ builder, {} };
+        ParseObjRange(file.Data(), file.Data() + file.Size(), sink);
+    }
+
+    builder.Finish();
+    LogLoaded(path, builder);
+    return out;
+}
+
+CpuMeshData ObjectLoader::ImportOBJ(const std::string& path, JobSystem* jobs)
+{
+    CpuMeshData data = LoadOBJ(path);
+    if (data.indices.empty()) return data;
+
+    const MeshOptimizeStats s = MeshOptimizer::Optimize(data);
+    std::cout << "vertex cache (FIFO " << MeshOptimizer::kCacheSize << "): ACMR " << s.before.acmr << " -> " << s.after.acmr
+        << ", ATVR " << s.before.atvr << " -> " << s.after.atvr << "\n";
+
+    MeshSimplifier::GenerateLods(data, jobs);
+    for (size_t i = 0; i < data.lods.size(); i++)
+    {
+        size_t indices = 0;
+        for (const SubMesh& s : data.lods[i].submeshes) indices += (size_t)s.indexCount;
+        std::cout << "LOD " << i + 1 << ": " << indices / 3 << " triangles, error " << data.lods[i].error << "\n";
+    }
+    std::cout << "Meshlets: " << MeshletBuilder::Build(data) << "\n";
+
+    if (!MeshCache::Write(path, data))
+        std::cout << "OBJ cache not written: " << path << "\n";
+    return data;
+}
+
+// ------------------------ Stream parser ------------------------
+
 // Parses a face token: "v", "v/vt", "v//vn", "v/vt/vn"
 static bool ParseFaceToken(const std::string& tok, int& vi, int& vti, int& vni)
 {
@@ -89,22 +796,12 @@ static bool ParseFaceToken(const std::string& tok, int& vi, int& vti, int& vni)
     return true;
 }
 
-static inline void AppendVertex11(std::vector<float>& dst,
-    const glm::vec3& p,
-    const glm::vec2& uv,
-    const glm::vec3& n)
+void ObjectLoader::SetDedupStats(bool enabled)
 {
-    // pos
-    dst.push_back(p.x); dst.push_back(p.y); dst.push_back(p.z);
-    // color (default white)
-    dst.push_back(1.0f); dst.push_back(1.0f); dst.push_back(1.0f);
-    // uv
-    dst.push_back(uv.x); dst.push_back(uv.y);
-    // normal
-    dst.push_back(n.x); dst.push_back(n.y); dst.push_back(n.z);
+    gDedupStats = enabled;
 }
 
-CpuMeshData ObjectLoader::LoadOBJ(const std::string& path)
+CpuMeshData ObjectLoader::LoadOBJStream(const std::string& path)
 {
     CpuMeshData out;
 
@@ -115,38 +812,7 @@ CpuMeshData ObjectLoader::LoadOBJ(const std::string& path)
         return out;
     }
 
-    std::vector<glm::vec3> positions;
-    std::vector<glm::vec2> texcoords;
-    std::vector<glm::vec3> normals;
-
-    std::unordered_map<ObjVertexKey, unsigned int, ObjVertexKeyHash> vertexRemap;
-
-    auto GetOrCreateVertexIndex = [&](int vi, int vti, int vni) -> unsigned int
-        {
-            // Support negative indices (OBJ spec)
-            if (vi < 0)  vi = (int)positions.size() + 1 + vi;
-            if (vti < 0) vti = (int)texcoords.size() + 1 + vti;
-            if (vni < 0) vni = (int)normals.size() + 1 + vni;
-
-            ObjVertexKey key{ vi, vti, vni };
-            auto it = vertexRemap.find(key);
-            if (it != vertexRemap.end())
-                return it->second;
-
-            glm::vec3 p(0.0f);
-            glm::vec2 uv(0.0f);
-            glm::vec3 n(0.0f, 0.0f, 1.0f);
-
-            if (vi > 0 && vi <= (int)positions.size()) p = positions[vi - 1];
-            if (vti > 0 && vti <= (int)texcoords.size()) uv = texcoords[vti - 1];
-            if (vni > 0 && vni <= (int)normals.size())   n = normals[vni - 1];
-
-            const unsigned int newIndex = (unsigned int)(out.vertices.size() / kVertexStrideFloats);
-            AppendVertex11(out.vertices, p, uv, n);
-
-            vertexRemap.emplace(key, newIndex);
-            return newIndex;
-        };
+    ObjMeshBuilder builder(out, path);
 
     std::string line;
     while (std::getline(file, line))
@@ -159,22 +825,33 @@ CpuMeshData ObjectLoader::LoadOBJ(const std::string& path)
 
         if (tag == "v")
         {
-            glm::vec3 p;
+            glm::vec3 p(0.0f);
             ss >> p.x >> p.y >> p.z;
-            positions.push_back(p);
+            builder.positions.push_back(p);
         }
         else if (tag == "vt")
         {
             // Some OBJ files may have 3 values (u v w). We read u v and ignore w if present.
-            glm::vec2 uv;
+            glm::vec2 uv(0.0f);
             ss >> uv.x >> uv.y;
-            texcoords.push_back(uv);
+            builder.texcoords.push_back(uv);
         }
         else if (tag == "vn")
         {
-            glm::vec3 n;
+            glm::vec3 n(0.0f);
             ss >> n.x >> n.y >> n.z;
-            normals.push_back(n);
+            builder.normals.push_back(n);
+        }
+        else if (tag == "usemtl")
+        {
+            std::string name;
+            ss >> name;
+            builder.UseMaterial(name);
+        }
+        else if (tag == "mtllib")
+        {
+            for (std::string lib; ss >> lib; )
+                builder.MaterialLib(lib);
         }
         else if (tag == "f")
         {
@@ -187,21 +864,14 @@ CpuMeshData ObjectLoader::LoadOBJ(const std::string& path)
                 if (!ParseFaceToken(tok, vi, vti, vni))
                     continue;
 
-                face.push_back(GetOrCreateVertexIndex(vi, vti, vni));
+                face.push_back(builder.GetOrCreateVertexIndex(vi, vti, vni));
             }
 
-            // Triangulate fan: (0, i, i+1)
-            for (size_t i = 1; i + 1 < face.size(); i++)
-            {
-                out.indices.push_back(face[0]);
-                out.indices.push_back(face[i]);
-                out.indices.push_back(face[i + 1]);
-            }
+            builder.EmitFan(face);
         }
     }
 
-    std::cout << "OBJ loaded: " << path << "\n";
-    std::cout << "floats: " << out.vertices.size() << " (stride " << kVertexStrideFloats << ")\n";
-    std::cout << "indices: " << out.indices.size() << "\n";
+    builder.Finish();
+    LogLoaded(path, builder);
     return out;
 }
@@ -1,10 +1,24 @@
 #pragma once
 
 #include <string>
-#include "Mesh.h"   // CpuMeshData
+#include "Mesh.h"   // CpuMeshData, JobSystem
 
 class ObjectLoader
 {
 public:
-    static CpuMeshData LoadOBJ(const std::string& path);
+    // Memory-mapped, in-place parser (no per-line allocations).
+    // Large files are split into line-aligned chunks parsed on up to threadCount threads
+    // (0 = one per hardware thread); the result does not depend on the thread count.
+    // A plain parse: vertices and triangles come out in file order.
+    static CpuMeshData LoadOBJ(const std::string& path, unsigned int threadCount = 0);
+
+    // The full import of an asset: LoadOBJ, MeshOptimizer (ACMR/ATVR change logged), the LOD chain, meshlets, then the MeshCache blob
+    // next to the source. The only path that writes the cache, so a blob always has every part.
+    static CpuMeshData ImportOBJ(const std::string& path, JobSystem* jobs = nullptr);
+
+    // Reference getline/stringstream parser; produces identical output to LoadOBJ
+    static CpuMeshData LoadOBJStream(const std::string& path);
+
+    // Log probe lengths and load factor of the vertex dedup table after each load
+    static void SetDedupStats(bool enabled);
 };
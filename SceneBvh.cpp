@@ -0,0 +1,316 @@
+#include "SceneBvh.h"
+#include <algorithm>
+
+static constexpr uint32_t kLeafItems = 4;
+static constexpr uint32_t kNoNode = ~0u;
+static constexpr int kStackDepth = 64;
+
+static float SurfaceArea(const glm::vec3& min, const glm::vec3& max)
+{
+    const glm::vec3 e = max - min;
+    return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+// Ray vs AABB (slab method); with acceptInside the entry distance is clamped to 0 for boxes
+// around the origin, otherwise those boxes miss
+static bool RayBox(const glm::vec3& origin, const glm::vec3& invDir,
+    const glm::vec3& min, const glm::vec3& max, float maxDist, bool acceptInside, float& entry)
+{
+    const glm::vec3 t0 = (min - origin) * invDir;
+    const glm::vec3 t1 = (max - origin) * invDir;
+
+    const glm::vec3 tMin = glm::min(t0, t1);
+    const glm::vec3 tMax = glm::max(t0, t1);
+
+    const float enter = std::max({ tMin.x, tMin.y, tMin.z });
+    const float exit = std::min({ tMax.x, tMax.y, tMax.z, maxDist });
+
+    if (enter < 0.0f && !acceptInside) return false;
+
+    entry = std::max(enter, 0.0f);
+    return entry <= exit;
+}
+
+void SceneBvh::Clear()
+{
+    nodes.clear();
+    parents.clear();
+    items.clear();
+    slotOfId.clear();
+    leafOfSlot.clear();
+    dirtyLeaves.clear();
+    leafDirty.clear();
+    buildArea = 0.0f;
+}
+
+void SceneBvh::Build(std::vector<Item> newItems)
+{
+    Clear();
+    items = std::move(newItems);
+    if (items.empty()) return;
+
+    // A binary tree with leaves of >= 1 item has at most 2n - 1 nodes
+    nodes.reserve(items.size() * 2);
+    parents.reserve(items.size() * 2);
+
+    Node root;
+    root.leftOrFirst = 0;
+    root.count = (uint32_t)items.size();
+    nodes.push_back(root);
+    parents.push_back(kNoNode);
+
+    Subdivide(0);
+
+    leafOfSlot.resize(items.size());
+    leafDirty.assign(nodes.size(), 0);
+
+    uint32_t maxId = 0;
+    for (const Item& it : items) maxId = std::max(maxId, it.id);
+    slotOfId.assign((size_t)maxId + 1, kNoNode);
+
+    for (uint32_t n = 0; n < nodes.size(); n++)
+    {
+        const Node& node = nodes[n];
+        for (uint32_t i = 0; i < node.count; i++)
+        {
+            const uint32_t slot = node.leftOrFirst + i;
+            leafOfSlot[slot] = n;
+            slotOfId[items[slot].id] = slot;
+        }
+    }
+
+    buildArea = RootArea();
+}
+
+// Splits at the median centroid along the longest axis of the centroid bounds
+void SceneBvh::Subdivide(uint32_t n)
+{
+    const uint32_t first = nodes[n].leftOrFirst;
+    const uint32_t count = nodes[n].count;
+
+    glm::vec3 lo = items[first].min, hi = items[first].max;
+    glm::vec3 cLo = 0.5f * (lo + hi), cHi = cLo;
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        lo = glm::min(lo, items[i].min);
+        hi = glm::max(hi, items[i].max);
+
+        const glm::vec3 c = 0.5f * (items[i].min + items[i].max);
+        cLo = glm::min(cLo, c);
+        cHi = glm::max(cHi, c);
+    }
+    nodes[n].min = lo;
+    nodes[n].max = hi;
+
+    if (count <= kLeafItems) return;
+
+    const glm::vec3 extent = cHi - cLo;
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+
+    const uint32_t half = count / 2;
+    std::nth_element(items.begin() + first, items.begin() + first + half, items.begin() + first + count,
+        [axis](const Item& a, const Item& b) { return a.min[axis] + a.max[axis] < b.min[axis] + b.max[axis]; });
+
+    const uint32_t left = (uint32_t)nodes.size();
+    Node l, r;
+    l.leftOrFirst = first;
+    l.count = half;
+    r.leftOrFirst = first + half;
+    r.count = count - half;
+    nodes.push_back(l);
+    nodes.push_back(r);
+    parents.push_back(n);
+    parents.push_back(n);
+
+    nodes[n].leftOrFirst = left;
+    nodes[n].count = 0;
+
+    Subdivide(left);
+    Subdivide(left + 1);
+}
+
+bool SceneBvh::Contains(uint32_t id) const
+{
+    return id < slotOfId.size() && slotOfId[id] != kNoNode;
+}
+
+void SceneBvh::GetBounds(uint32_t id, glm::vec3& min, glm::vec3& max) const
+{
+    const Item& it = items[slotOfId[id]];
+    min = it.min;
+    max = it.max;
+}
+
+void SceneBvh::Update(uint32_t id, const glm::vec3& min, const glm::vec3& max)
+{
+    if (!Contains(id)) return;
+
+    const uint32_t slot = slotOfId[id];
+    items[slot].min = min;
+    items[slot].max = max;
+
+    const uint32_t leaf = leafOfSlot[slot];
+    if (!leafDirty[leaf])
+    {
+        leafDirty[leaf] = 1;
+        dirtyLeaves.push_back(leaf);
+    }
+}
+
+void SceneBvh::RefitLeaf(uint32_t n)
+{
+    Node& node = nodes[n];
+    node.min = items[node.leftOrFirst].min;
+    node.max = items[node.leftOrFirst].max;
+    for (uint32_t i = 1; i < node.count; i++)
+    {
+        node.min = glm::min(node.min, items[node.leftOrFirst + i].min);
+        node.max = glm::max(node.max, items[node.leftOrFirst + i].max);
+    }
+}
+
+// Only the dirty leaves and their ancestors are touched; a walk stops once a parent's box is unchanged
+void SceneBvh::Refit()
+{
+    for (uint32_t leaf : dirtyLeaves)
+    {
+        leafDirty[leaf] = 0;
+        RefitLeaf(leaf);
+
+        for (uint32_t n = parents[leaf]; n != kNoNode; n = parents[n])
+        {
+            const Node& l = nodes[nodes[n].leftOrFirst];
+            const Node& r = nodes[nodes[n].leftOrFirst + 1];
+            const glm::vec3 lo = glm::min(l.min, r.min);
+            const glm::vec3 hi = glm::max(l.max, r.max);
+
+            if (lo == nodes[n].min && hi == nodes[n].max) break;
+            nodes[n].min = lo;
+            nodes[n].max = hi;
+        }
+    }
+    dirtyLeaves.clear();
+}
+
+float SceneBvh::RootArea() const
+{
+    return nodes.empty() ? 0.0f : SurfaceArea(nodes[0].min, nodes[0].max);
+}
+
+void SceneBvh::AppendSubtree(uint32_t n, std::vector<uint32_t>& outIds) const
+{
+    uint32_t stack[kStackDepth];
+    int top = 0;
+    stack[top++] = n;
+
+    while (top > 0)
+    {
+        const Node& node = nodes[stack[--top]];
+        if (node.count)
+        {
+            for (uint32_t i = 0; i < node.count; i++)
+                outIds.push_back(items[node.leftOrFirst + i].id);
+            continue;
+        }
+        stack[top++] = node.leftOrFirst + 1;
+        stack[top++] = node.leftOrFirst;
+    }
+}
+
+size_t SceneBvh::Cull(const Frustum& f, std::vector<uint32_t>& outIds) const
+{
+    if (nodes.empty()) return 0;
+
+    uint32_t stack[kStackDepth];
+    int top = 0;
+    stack[top++] = 0;
+    size_t visited = 0;
+
+    while (top > 0)
+    {
+        const uint32_t n = stack[--top];
+        const Node& node = nodes[n];
+        visited++;
+
+        const FrustumTest test = f.TestBox(node.min, node.max);
+        if (test == FrustumTest::Outside) continue;
+
+        // Fully inside: everything below is visible, no more plane tests
+        if (test == FrustumTest::Inside)
+        {
+            AppendSubtree(n, outIds);
+            continue;
+        }
+
+        if (node.count)
+        {
+            for (uint32_t i = 0; i < node.count; i++)
+            {
+                const Item& it = items[node.leftOrFirst + i];
+                if (f.TestBox(it.min, it.max) != FrustumTest::Outside)
+                    outIds.push_back(it.id);
+            }
+            continue;
+        }
+
+        stack[top++] = node.leftOrFirst + 1;
+        stack[top++] = node.leftOrFirst;
+    }
+
+    return visited;
+}
+
+bool SceneBvh::Raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist, uint32_t& hitId, float& hitDist,
+    const ItemFilter& accept) const
+{
+    if (nodes.empty()) return false;
+
+    const glm::vec3 invDir = 1.0f / dir;
+    float best = maxDist;
+    bool hit = false;
+
+    float entry;
+    if (!RayBox(origin, invDir, nodes[0].min, nodes[0].max, best, true, entry)) return false;
+
+    uint32_t stack[kStackDepth];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const Node& node = nodes[stack[--top]];
+
+        if (node.count)
+        {
+            for (uint32_t i = 0; i < node.count; i++)
+            {
+                const Item& it = items[node.leftOrFirst + i];
+                if (accept && !accept(it.id)) continue;
+                if (RayBox(origin, invDir, it.min, it.max, best, false, entry) && (!hit || entry < best))
+                {
+                    best = entry;
+                    hitId = it.id;
+                    hit = true;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first so farther subtrees get pruned by the best hit so far
+        uint32_t a = node.leftOrFirst, b = node.leftOrFirst + 1;
+        float da, db;
+        bool ha = RayBox(origin, invDir, nodes[a].min, nodes[a].max, best, true, da);
+        bool hb = RayBox(origin, invDir, nodes[b].min, nodes[b].max, best, true, db);
+
+        if (ha && hb && db < da) { std::swap(a, b); std::swap(da, db); }
+        else if (!ha) { a = b; ha = hb; hb = false; }
+
+        if (hb) stack[top++] = b;
+        if (ha) stack[top++] = a;
+    }
+
+    if (hit) hitDist = best;
+    return hit;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+
+// Bounding volume hierarchy over world-space AABBs, identified by caller ids (object indices).
+// Built top-down by median split, then refit in place as items move.
+class SceneBvh
+{
+public:
+    struct Item
+    {
+        glm::vec3 min;
+        uint32_t id;
+        glm::vec3 max;
+    };
+
+    // 32 bytes; children of an interior node are adjacent, parents come before children
+    struct Node
+    {
+        glm::vec3 min;
+        uint32_t leftOrFirst;   // interior: left child (right = +1), leaf: first item
+        glm::vec3 max;
+        uint32_t count;         // 0 = interior
+    };
+
+    void Build(std::vector<Item> items);
+    void Clear();
+
+    bool Contains(uint32_t id) const;
+    void GetBounds(uint32_t id, glm::vec3& min, glm::vec3& max) const;
+
+    // Moves an item; the tree is only consistent again after Refit
+    void Update(uint32_t id, const glm::vec3& min, const glm::vec3& max);
+    void Refit();
+
+    // Appends the ids of items touching the frustum; returns the number of nodes visited
+    size_t Cull(const Frustum& f, std::vector<uint32_t>& outIds) const;
+
+    // Nearest item box hit along the ray within maxDist; boxes containing the origin are skipped,
+    // so a camera standing inside an object can still pick what is in front of it. Items the
+    // filter (if any) rejects are transparent to the ray.
+    using ItemFilter = std::function<bool(uint32_t id)>;
+    bool Raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist, uint32_t& hitId, float& hitDist,
+        const ItemFilter& accept = {}) const;
+
+    size_t ItemCount() const { return items.size(); }
+    size_t NodeCount() const { return nodes.size(); }
+
+    // Root surface area now vs. right after Build, to spot a tree degraded by refits
+    float RootArea() const;
+    float BuildArea() const { return buildArea; }
+
+private:
+    void Subdivide(uint32_t node);
+    void RefitLeaf(uint32_t node);
+    void AppendSubtree(uint32_t node, std::vector<uint32_t>& outIds) const;
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> parents;
+    std::vector<Item> items;            // reordered so every leaf covers a contiguous range
+
+    std::vector<uint32_t> slotOfId;     // id -> index into items, ~0u if absent
+    std::vector<uint32_t> leafOfSlot;   // items index -> leaf node
+
+    std::vector<uint32_t> dirtyLeaves;
+    std::vector<uint8_t> leafDirty;
+
+    float buildArea = 0.0f;
+};
@@ -0,0 +1,57 @@
+#include "SimulationThread.h"
+
+void SimulationThread::Start(UpdateFn fn)
+{
+    Stop();
+
+    update = std::move(fn);
+    running.store(true);
+    thread = std::thread([this]() { Loop(); });
+}
+
+void SimulationThread::Stop()
+{
+    if (!thread.joinable()) return;
+
+    running.store(false);
+    inputSerial.fetch_add(1, std::memory_order_release);
+    inputSerial.notify_one();
+    thread.join();
+}
+
+void SimulationThread::PublishInput(const InputSample& in)
+{
+    input.WriteBuffer() = in;
+    input.Publish();
+
+    inputSerial.fetch_add(1, std::memory_order_release);
+    inputSerial.notify_one();
+}
+
+const SceneSnapshot* SimulationThread::LatestSnapshot(bool* isNew)
+{
+    const bool fresh = scene.Acquire();
+    haveSnapshot = haveSnapshot || fresh;
+
+    if (isNew) *isNew = fresh;
+    return haveSnapshot ? &scene.ReadBuffer() : nullptr;
+}
+
+void SimulationThread::Loop()
+{
+    uint64_t seen = 0;
+    for (;;)
+    {
+        // Sleeps until a new sample (or Stop) bumps the serial
+        inputSerial.wait(seen, std::memory_order_acquire);
+        seen = inputSerial.load(std::memory_order_acquire);
+        if (!running.load()) return;
+
+        if (!input.Acquire()) continue;
+
+        SceneSnapshot& out = scene.WriteBuffer();
+        update(input.ReadBuffer(), out);
+        out.serial = ++produced;
+        scene.Publish();
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#include "Camera.h"
+#include "Mesh.h"
+#include "TripleBuffer.h"
+
+// What the GLFW thread samples each frame for the update stage (GLFW input is main-thread only)
+struct InputSample
+{
+    Camera camera{ 1, 1, glm::vec3(0.0f) };
+    float timeSec = 0.0f;
+    std::chrono::steady_clock::time_point sampledAt;
+
+    // Counted, so a click between two updates is still seen (several merge into the last one)
+    uint32_t pickSerial = 0;
+    glm::vec3 pickOrigin{ 0.0f };
+    glm::vec3 pickDir{ 0.0f, 0.0f, -1.0f };
+};
+
+// Result of one update, drawn as is by the GLFW thread
+struct SceneSnapshot
+{
+    RenderSnapshot render;
+    std::chrono::steady_clock::time_point inputSampledAt;  // of the sample it was built from
+    uint64_t serial = 0;
+};
+
+// Runs the update stage on its own thread, once per published input sample: it reads the newest
+// input and fills the next snapshot. Both hand-offs are triple buffers, so a slow update never
+// blocks rendering (the last snapshot is drawn again) and a slow frame never blocks the update.
+class SimulationThread
+{
+public:
+    using UpdateFn = std::function<void(const InputSample& in, SceneSnapshot& out)>;
+
+    SimulationThread() = default;
+    ~SimulationThread() { Stop(); }
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void Start(UpdateFn fn);
+    void Stop();
+
+    // GLFW thread
+    void PublishInput(const InputSample& in);
+    // Newest snapshot, or the last one again if no update finished since; nullptr before the first
+    const SceneSnapshot* LatestSnapshot(bool* isNew = nullptr);
+
+private:
+    void Loop();
+
+    TripleBuffer<InputSample> input;
+    TripleBuffer<SceneSnapshot> scene;
+    std::atomic<uint64_t> inputSerial{ 0 };     // bumped per sample and on Stop, waited on by Loop
+    std::atomic<bool> running{ false };
+    std::thread thread;
+    UpdateFn update;
+
+    uint64_t produced = 0;                      // update thread
+    bool haveSnapshot = false;                  // GLFW thread
+};
@@ -0,0 +1,125 @@
+#include "StreamRing.h"
+#include "GlExtensions.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static constexpr size_t kMinSegmentBytes = size_t(1) << 20;
+static constexpr GLuint64 kFenceTimeoutNs = 1000000000ull;
+
+void StreamRing::Create(size_t bytesPerSegment)
+{
+    segmentBytes = bytesPerSegment;
+    const GLsizeiptr total = (GLsizeiptr)(segmentBytes * kFramesInFlight);
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+
+    const GlExtensions& ext = GetGlExtensions();
+    if (allowPersistent && ext.bufferStorage)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        ext.BufferStorage(GL_COPY_WRITE_BUFFER, total, nullptr, flags);
+        mapped = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags);
+    }
+    else
+        glBufferData(GL_COPY_WRITE_BUFFER, total, nullptr, GL_STREAM_DRAW);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void StreamRing::WaitForSegment(unsigned int s)
+{
+    if (!fences[s]) return;
+
+    for (;;)
+    {
+        const GLenum r = glClientWaitSync(fences[s], GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNs);
+        if (r != GL_TIMEOUT_EXPIRED) break;     // signaled, or failed: nothing left to wait for
+    }
+
+    glDeleteSync(fences[s]);
+    fences[s] = nullptr;
+}
+
+void StreamRing::BeginFrame(size_t bytes)
+{
+    if (bytes > segmentBytes)
+    {
+        // Every segment may still be read: drain them all before replacing the buffer
+        for (unsigned int s = 0; s < kFramesInFlight; s++)
+            WaitForSegment(s);
+
+        const size_t grown = std::max({ bytes, segmentBytes * 2, kMinSegmentBytes });
+        Delete();
+        Create(grown);
+    }
+
+    segment = (segment + 1) % kFramesInFlight;
+    WaitForSegment(segment);
+
+    head = segment * segmentBytes;
+    segmentEnd = head + segmentBytes;
+}
+
+size_t StreamRing::Write(const void* data, size_t bytes, size_t alignment)
+{
+    const size_t offset = (head + alignment - 1) / alignment * alignment;
+    if (offset + bytes > segmentEnd)
+    {
+        if (!overflowReported)
+            std::cout << "StreamRing: frame wrote more than it reserved in BeginFrame" << std::endl;
+        overflowReported = true;
+        return kNoOffset;
+    }
+
+    if (mapped)
+        std::memcpy(mapped + offset, data, bytes);
+    else if (bytes > 0)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        void* dst = glMapBufferRange(GL_COPY_WRITE_BUFFER, (GLintptr)offset, (GLsizeiptr)bytes,
+            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if (dst)
+        {
+            std::memcpy(dst, data, bytes);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    head = offset + bytes;
+    return offset;
+}
+
+void StreamRing::EndFrame()
+{
+    if (fences[segment]) glDeleteSync(fences[segment]);
+    fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamRing::Delete()
+{
+    for (GLsync& f : fences)
+    {
+        if (f) glDeleteSync(f);
+        f = nullptr;
+    }
+
+    if (buffer)
+    {
+        if (mapped)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+
+    buffer = 0;
+    mapped = nullptr;
+    segmentBytes = 0;
+    head = 0;
+    segmentEnd = 0;
+}
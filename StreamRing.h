@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <glad/glad.h>
+
+// One buffer split into kFramesInFlight segments for data written once per frame and read only by
+// that frame's draws: instance attributes, uniform blocks. A frame fills its segment front to back
+// in aligned slices, and BeginFrame first waits on the fence EndFrame left on that segment
+// kFramesInFlight frames ago, so the CPU never overwrites what the GPU may still read and the driver
+// never has to stall or copy for it. With GL 4.4 / ARB_buffer_storage the buffer is mapped once,
+// persistent and coherent; otherwise every write maps its slice unsynchronized, made safe by the
+// same fences.
+class StreamRing
+{
+public:
+    static constexpr unsigned int kFramesInFlight = 3;
+    static constexpr size_t kNoOffset = ~size_t(0);
+
+    explicit StreamRing(bool allowPersistent = true) : allowPersistent(allowPersistent) {}
+
+    // Starts the next segment, grown (after the GPU is done with the old buffer) to hold `bytes`.
+    // `bytes` must cover all of the frame's writes including their alignment padding.
+    void BeginFrame(size_t bytes);
+    // Copies `bytes` in at the next multiple of `alignment`; returns the offset into Buffer(),
+    // kNoOffset (reported) if the frame's reservation is exceeded
+    size_t Write(const void* data, size_t bytes, size_t alignment);
+    void EndFrame();
+
+    GLuint Buffer() const { return buffer; }
+    bool Persistent() const { return mapped != nullptr; }
+    size_t SegmentBytes() const { return segmentBytes; }
+
+    void Delete();
+
+private:
+    void Create(size_t bytesPerSegment);
+    void WaitForSegment(unsigned int s);
+
+    GLuint buffer = 0;
+    char* mapped = nullptr;                 // persistent mapping, nullptr when mapping per write
+    size_t segmentBytes = 0;
+    unsigned int segment = 0;
+    size_t head = 0;                        // next free byte, absolute
+    size_t segmentEnd = 0;
+    GLsync fences[kFramesInFlight] = {};
+    bool allowPersistent = true;
+    bool overflowReported = false;
+};
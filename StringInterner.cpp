@@ -0,0 +1,24 @@
+#include "StringInterner.h"
+
+uint32_t StringInterner::Intern(const std::string& s)
+{
+    auto it = ids.find(s);
+    if (it != ids.end()) return it->second;
+
+    const uint32_t id = (uint32_t)names.size();
+    ids.emplace(s, id);
+    names.push_back(s);
+    return id;
+}
+
+uint32_t StringInterner::Find(const std::string& s) const
+{
+    auto it = ids.find(s);
+    return it != ids.end() ? it->second : kInvalid;
+}
+
+void StringInterner::Clear()
+{
+    ids.clear();
+    names.clear();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Maps strings to dense integer ids (0, 1, 2, ...), so hot paths index arrays instead of hashing strings
+class StringInterner
+{
+public:
+    static constexpr uint32_t kInvalid = ~0u;
+
+    uint32_t Intern(const std::string& s);
+    uint32_t Find(const std::string& s) const;     // kInvalid if never interned
+
+    const std::string& Name(uint32_t id) const { return names[id]; }
+    size_t Size() const { return names.size(); }
+
+    void Clear();
+
+private:
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<std::string> names;
+};
@@ -0,0 +1,311 @@
+#include "TransformStore.h"
+#include "Mesh.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSFORM_SSE 1
+#endif
+
+static constexpr float kDegToRad = 3.14159265358979f / 180.0f;
+static constexpr float kRotateXYSecondAxis = 0.7f;   // RotateXY spins around Y at 0.7x the X rate
+
+void TransformStore::Group::Write(uint32_t i, const SceneObject& o)
+{
+    const glm::vec3 p = (o.motion == Motion::BobY) ? o.basePos : o.pos;
+    px[i] = p.x; py[i] = p.y; pz[i] = p.z;
+    sx[i] = o.scale.x; sy[i] = o.scale.y; sz[i] = o.scale.z;
+    rate[i] = (o.motion == Motion::BobY) ? o.bobFreq : o.rotSpeedDeg * kDegToRad;
+    amp[i] = o.bobAmp;
+}
+
+void TransformStore::Group::Append(uint32_t objectIndex, const SceneObject& o)
+{
+    px.emplace_back(); py.emplace_back(); pz.emplace_back();
+    sx.emplace_back(); sy.emplace_back(); sz.emplace_back();
+    rate.emplace_back(); amp.emplace_back();
+    object.push_back(objectIndex);
+    Write((uint32_t)object.size() - 1, o);
+}
+
+void TransformStore::Group::RemoveAt(uint32_t i)
+{
+    const size_t last = object.size() - 1;
+    px[i] = px[last]; py[i] = py[last]; pz[i] = pz[last];
+    sx[i] = sx[last]; sy[i] = sy[last]; sz[i] = sz[last];
+    rate[i] = rate[last]; amp[i] = amp[last];
+    object[i] = object[last];
+
+    px.pop_back(); py.pop_back(); pz.pop_back();
+    sx.pop_back(); sy.pop_back(); sz.pop_back();
+    rate.pop_back(); amp.pop_back();
+    object.pop_back();
+}
+
+void TransformStore::Add(const SceneObject& o)
+{
+    const uint32_t g = (uint32_t)o.motion;
+    where.push_back(Where{ g, (uint32_t)groups[g].Size() });
+    groups[g].Append((uint32_t)where.size() - 1, o);
+}
+
+void TransformStore::Detach(uint32_t object)
+{
+    const Where w = where[object];
+    Group& g = groups[w.group];
+
+    g.RemoveAt(w.index);
+    if (w.index < g.Size())
+        where[g.object[w.index]].index = w.index;
+}
+
+void TransformStore::Sync(uint32_t object, const SceneObject& o)
+{
+    Where& w = where[object];
+    if (w.group == (uint32_t)o.motion)
+    {
+        groups[w.group].Write(w.index, o);
+        return;
+    }
+
+    Detach(object);
+    const uint32_t g = (uint32_t)o.motion;
+    where[object] = Where{ g, (uint32_t)groups[g].Size() };
+    groups[g].Append(object, o);
+}
+
+void TransformStore::Remove(uint32_t object)
+{
+    Detach(object);
+
+    // The last object takes over this index, as in the object array
+    const uint32_t last = (uint32_t)where.size() - 1;
+    if (object != last)
+    {
+        where[object] = where[last];
+        groups[where[object].group].object[where[object].index] = object;
+    }
+    where.pop_back();
+}
+
+void TransformStore::Clear()
+{
+    for (Group& g : groups) g = Group{};
+    where.clear();
+}
+
+#ifdef TRANSFORM_SSE
+
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// sin and cos of four angles: reduce to [-pi, pi], fold into [-pi/2, pi/2], then Taylor
+// polynomials to x^11 / x^12 (error below 1e-7 on the folded range)
+static inline void SinCos4(__m128 x, __m128& s, __m128& c)
+{
+    const __m128 invTwoPi = _mm_set1_ps(0.159154943f);
+    const __m128 twoPiHi = _mm_set1_ps(6.28125f);
+    const __m128 twoPiLo = _mm_set1_ps(0.0019353071795864769f);
+    const __m128 pi = _mm_set1_ps(3.14159265358979f);
+    const __m128 halfPi = _mm_set1_ps(1.57079632679490f);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+
+    const __m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, invTwoPi)));
+    x = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(k, twoPiHi)), _mm_mul_ps(k, twoPiLo));
+
+    // sin(pi - x) = sin(x), cos(pi - x) = -cos(x); same for -pi - x
+    const __m128 above = _mm_cmpgt_ps(x, halfPi);
+    const __m128 below = _mm_cmplt_ps(x, _mm_xor_ps(halfPi, signBit));
+    x = Select(above, _mm_sub_ps(pi, x), x);
+    x = Select(below, _mm_sub_ps(_mm_xor_ps(pi, signBit), x), x);
+    const __m128 cosSign = _mm_and_ps(_mm_or_ps(above, below), signBit);
+
+    const __m128 x2 = _mm_mul_ps(x, x);
+
+    __m128 ps = _mm_set1_ps(-2.5052108e-8f);
+    ps = _mm_add_ps(_mm_mul_ps(ps, x2), _mm_set1_ps(2.7557319e-6f));
+    ps = _mm_add_ps(_mm_mul_ps(ps, x2), _mm_set1_ps(-1.9841270e-4f));
+    ps = _mm_add_ps(_mm_mul_ps(ps, x2), _mm_set1_ps(8.3333333e-3f));
+    ps = _mm_add_ps(_mm_mul_ps(ps, x2), _mm_set1_ps(-1.6666667e-1f));
+    s = _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(ps, x2), x));
+
+    __m128 pc = _mm_set1_ps(2.0876757e-9f);
+    pc = _mm_add_ps(_mm_mul_ps(pc, x2), _mm_set1_ps(-2.7557319e-7f));
+    pc = _mm_add_ps(_mm_mul_ps(pc, x2), _mm_set1_ps(2.4801587e-5f));
+    pc = _mm_add_ps(_mm_mul_ps(pc, x2), _mm_set1_ps(-1.3888889e-3f));
+    pc = _mm_add_ps(_mm_mul_ps(pc, x2), _mm_set1_ps(4.1666667e-2f));
+    pc = _mm_add_ps(_mm_mul_ps(pc, x2), _mm_set1_ps(-0.5f));
+    c = _mm_xor_ps(_mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(pc, x2)), cosSign);
+}
+
+// Four fields by entry index; a run of consecutive entries (objects visited in storage order)
+// is a single unaligned load
+static inline __m128 Gather(const float* v, const uint32_t* k, bool run)
+{
+    return run ? _mm_loadu_ps(v + k[0]) : _mm_setr_ps(v[k[0]], v[k[1]], v[k[2]], v[k[3]]);
+}
+
+// Model matrix = T * R * S with R = Rx(a) * Ry(b), written column by column for four objects.
+// Columns of R: (cb, sa*sb, -ca*sb), (0, ca, sa), (sb, -sa*cb, ca*cb).
+template <Motion M>
+static void EvaluateGroup(const float* const* g, const uint32_t* index, const uint32_t* slot,
+    size_t n, float t, glm::mat4* out)
+{
+    enum { PX, PY, PZ, SX, SY, SZ, RATE, AMP };
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128 time = _mm_set1_ps(t);
+
+    for (size_t i = 0; i < n; i += 4)
+    {
+        // Short tail: repeat the last entry, only the valid lanes are stored
+        const size_t lanes = (n - i < 4) ? n - i : 4;
+        uint32_t k[4];
+        for (size_t l = 0; l < 4; l++)
+            k[l] = index[i + (l < lanes ? l : lanes - 1)];
+        const bool run = k[3] == k[0] + 3 && k[1] == k[0] + 1 && k[2] == k[0] + 2;
+
+        const __m128 px = Gather(g[PX], k, run);
+        __m128 py = Gather(g[PY], k, run);
+        const __m128 pz = Gather(g[PZ], k, run);
+        const __m128 sx = Gather(g[SX], k, run);
+        const __m128 sy = Gather(g[SY], k, run);
+        const __m128 sz = Gather(g[SZ], k, run);
+
+        __m128 sa = zero, ca = one, sb = zero, cb = one;
+
+        if constexpr (M == Motion::BobY)
+        {
+            __m128 s, c;
+            SinCos4(_mm_mul_ps(time, Gather(g[RATE], k, run)), s, c);
+            py = _mm_add_ps(py, _mm_mul_ps(Gather(g[AMP], k, run), s));
+        }
+        else if constexpr (M == Motion::RotateX)
+            SinCos4(_mm_mul_ps(time, Gather(g[RATE], k, run)), sa, ca);
+        else if constexpr (M == Motion::RotateY)
+            SinCos4(_mm_mul_ps(time, Gather(g[RATE], k, run)), sb, cb);
+        else if constexpr (M == Motion::RotateXY)
+        {
+            const __m128 angle = _mm_mul_ps(time, Gather(g[RATE], k, run));
+            SinCos4(angle, sa, ca);
+            SinCos4(_mm_mul_ps(angle, _mm_set1_ps(kRotateXYSecondAxis)), sb, cb);
+        }
+
+        __m128 col[4][4] = {
+            { _mm_mul_ps(sx, cb), _mm_mul_ps(sx, _mm_mul_ps(sa, sb)), _mm_mul_ps(sx, _mm_xor_ps(_mm_mul_ps(ca, sb), signBit)), zero },
+            { zero, _mm_mul_ps(sy, ca), _mm_mul_ps(sy, sa), zero },
+            { _mm_mul_ps(sz, sb), _mm_mul_ps(sz, _mm_xor_ps(_mm_mul_ps(sa, cb), signBit)), _mm_mul_ps(sz, _mm_mul_ps(ca, cb)), zero },
+            { px, py, pz, one },
+        };
+
+        // Lanes -> objects: after the transpose col[c][l] is column c of object l
+        for (int c = 0; c < 4; c++)
+            _MM_TRANSPOSE4_PS(col[c][0], col[c][1], col[c][2], col[c][3]);
+
+        for (size_t l = 0; l < lanes; l++)
+        {
+            float* m = &out[slot[i + l]][0][0];
+            for (int c = 0; c < 4; c++)
+                _mm_storeu_ps(m + 4 * c, col[c][l]);
+        }
+    }
+}
+
+#else
+
+template <Motion M>
+static void EvaluateGroup(const float* const* g, const uint32_t* index, const uint32_t* slot,
+    size_t n, float t, glm::mat4* out)
+{
+    enum { PX, PY, PZ, SX, SY, SZ, RATE, AMP };
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const uint32_t k = index[i];
+        float py = g[PY][k];
+        float sa = 0.0f, ca = 1.0f, sb = 0.0f, cb = 1.0f;
+
+        const float angle = t * g[RATE][k];
+        if constexpr (M == Motion::BobY) py += g[AMP][k] * std::sin(angle);
+        else if constexpr (M == Motion::RotateX) { sa = std::sin(angle); ca = std::cos(angle); }
+        else if constexpr (M == Motion::RotateY) { sb = std::sin(angle); cb = std::cos(angle); }
+        else if constexpr (M == Motion::RotateXY)
+        {
+            sa = std::sin(angle); ca = std::cos(angle);
+            sb = std::sin(angle * kRotateXYSecondAxis); cb = std::cos(angle * kRotateXYSecondAxis);
+        }
+
+        const float sx = g[SX][k], sy = g[SY][k], sz = g[SZ][k];
+        glm::mat4& m = out[slot[i]];
+        m[0] = glm::vec4(sx * cb, sx * sa * sb, -sx * ca * sb, 0.0f);
+        m[1] = glm::vec4(0.0f, sy * ca, sy * sa, 0.0f);
+        m[2] = glm::vec4(sz * sb, -sz * sa * cb, sz * ca * cb, 0.0f);
+        m[3] = glm::vec4(g[PX][k], py, g[PZ][k], 1.0f);
+    }
+}
+
+#endif
+
+// Requests are handled in blocks so the matrices written by the different group kernels
+// land in the same few cache lines instead of each group sweeping the whole output
+static constexpr size_t kEvaluateBlock = 512;
+
+void TransformStore::Evaluate(const uint32_t* objectIds, size_t count, float t, glm::mat4* out) const
+{
+    const float* fields[kGroups][8];
+    for (int g = 0; g < kGroups; g++)
+    {
+        const Group& grp = groups[g];
+        const float* f[] = { grp.px.data(), grp.py.data(), grp.pz.data(),
+            grp.sx.data(), grp.sy.data(), grp.sz.data(), grp.rate.data(), grp.amp.data() };
+        std::copy(f, f + 8, fields[g]);
+    }
+
+    uint32_t index[kEvaluateBlock], slot[kEvaluateBlock];
+
+    for (size_t base = 0; base < count; base += kEvaluateBlock)
+    {
+        const size_t blockCount = std::min(kEvaluateBlock, count - base);
+
+        // Counting sort of the block by group, keeping request order inside each group
+        size_t start[kGroups + 1] = {};
+        for (size_t i = 0; i < blockCount; i++)
+            start[where[objectIds[base + i]].group + 1]++;
+        for (int g = 0; g < kGroups; g++)
+            start[g + 1] += start[g];
+
+        size_t next[kGroups];
+        std::copy(start, start + kGroups, next);
+
+        for (size_t i = 0; i < blockCount; i++)
+        {
+            const Where w = where[objectIds[base + i]];
+            const size_t r = next[w.group]++;
+            index[r] = w.index;
+            slot[r] = (uint32_t)(base + i);
+        }
+
+        for (int g = 0; g < kGroups; g++)
+        {
+            const size_t n = start[g + 1] - start[g];
+            if (n == 0) continue;
+
+            const uint32_t* gi = index + start[g];
+            const uint32_t* gs = slot + start[g];
+
+            switch ((Motion)g)
+            {
+            case Motion::None:     EvaluateGroup<Motion::None>(fields[g], gi, gs, n, t, out); break;
+            case Motion::BobY:     EvaluateGroup<Motion::BobY>(fields[g], gi, gs, n, t, out); break;
+            case Motion::RotateX:  EvaluateGroup<Motion::RotateX>(fields[g], gi, gs, n, t, out); break;
+            case Motion::RotateY:  EvaluateGroup<Motion::RotateY>(fields[g], gi, gs, n, t, out); break;
+            case Motion::RotateXY: EvaluateGroup<Motion::RotateXY>(fields[g], gi, gs, n, t, out); break;
+            }
+        }
+    }
+}
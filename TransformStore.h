@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+struct SceneObject;
+
+// Transform and motion parameters of every scene object, kept as SoA arrays grouped by Motion,
+// so model matrices are evaluated four at a time without per-object branching.
+// Mirrors MeshSystem::objects: object indices match, edits are pushed in through Sync.
+class TransformStore
+{
+public:
+    void Add(const SceneObject& o);                        // takes the next object index
+    void Sync(uint32_t object, const SceneObject& o);      // after an edit; may change group
+    void Remove(uint32_t object);                          // swap-and-pop, like the object array
+    void Clear();
+
+    size_t Size() const { return where.size(); }
+
+    // out[i] = model matrix of objectIds[i] at time t
+    void Evaluate(const uint32_t* objectIds, size_t count, float t, glm::mat4* out) const;
+
+private:
+    static constexpr int kGroups = 5;  // one per Motion
+
+    struct Group
+    {
+        std::vector<float> px, py, pz;  // translation (BobY: base position)
+        std::vector<float> sx, sy, sz;
+        std::vector<float> rate;        // radians per second (rotations) or bob frequency
+        std::vector<float> amp;         // bob amplitude
+        std::vector<uint32_t> object;
+
+        size_t Size() const { return object.size(); }
+        void Write(uint32_t index, const SceneObject& o);
+        void Append(uint32_t objectIndex, const SceneObject& o);
+        void RemoveAt(uint32_t index);  // swap-and-pop; the caller fixes `where`
+    };
+
+    struct Where
+    {
+        uint32_t group;
+        uint32_t index;
+    };
+
+    void Detach(uint32_t object);
+
+    Group groups[kGroups];
+    std::vector<Where> where;           // object -> group entry
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Single-producer single-consumer hand-off of the latest value, without locks.
+// The writer fills WriteBuffer() and publishes it; the reader swaps in the newest published
+// slot with Acquire and keeps reading it until the next Acquire. Values published in between
+// are skipped, neither side ever waits for the other.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+    explicit TripleBuffer(const T& init) : slots{ init, init, init } {}
+
+    // Writer side
+    T& WriteBuffer() { return slots[back]; }
+
+    void Publish()
+    {
+        back = middle.exchange(uint8_t(back | kFresh), std::memory_order_acq_rel) & kIndex;
+    }
+
+    // True while the last published value has not been acquired yet
+    bool Unread() const { return (middle.load(std::memory_order_acquire) & kFresh) != 0; }
+
+    // Reader side; false (and the current slot kept) if nothing new was published
+    bool Acquire()
+    {
+        if (!Unread()) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & kIndex;
+        return true;
+    }
+
+    const T& ReadBuffer() const { return slots[front]; }
+
+private:
+    static constexpr uint8_t kIndex = 0x3;
+    static constexpr uint8_t kFresh = 0x4;
+
+    T slots[3];
+    std::atomic<uint8_t> middle{ 1 };  // slot index, plus kFresh once published and not yet read
+    uint8_t front = 0;                 // owned by the reader
+    uint8_t back = 2;                  // owned by the writer
+};
@@ -0,0 +1,46 @@
+// Shared by the vertex shaders through #include "VertexCommon.glsl", expanded by Shader on load:
+// the frame uniform block, the per-instance model inputs and the GPU motion decode. The motion
+// buffer rows are PackMotionParams in Mesh.cpp; Cull.comp reads the same rows for its bounds.
+
+layout (location = 4) in mat4 aModel;	// per instance
+layout (location = 8) in uint aObject;	// per instance with GPU motion: object index
+
+layout (std140) uniform FrameData	// per frame, see FrameUniforms in Mesh.h
+{
+	mat4 camMatrix;
+	vec4 camPos;		// xyz
+	vec4 lightColor;
+	vec4 lightPos;		// xyz
+	vec4 motionTime;	// x = seconds, y = 1 when ModelMatrix() animates from motionParams
+};
+
+uniform samplerBuffer motionParams;	// per object, see PackMotionParams in Mesh.cpp
+uniform vec4 vertexDecode[2];		// per mesh, see VertexDecode in VertexLayout.h
+
+// GPU motion: T * Rx(a) * Ry(b) * S from static parameters, same math as TransformStore
+mat4 ModelMatrix()
+{
+	if (motionTime.y == 0.0)
+		return aModel;
+
+	int row = int(aObject) * 3;
+	vec4 pos = texelFetch(motionParams, row);		// xyz, w = Motion
+	vec4 scale = texelFetch(motionParams, row + 1);	// xyz, w = rad/s or bob frequency
+	float amp = texelFetch(motionParams, row + 2).x;
+
+	int motion = int(pos.w);
+	float angle = motionTime.x * scale.w;
+	float a = 0.0, b = 0.0;
+
+	if (motion == 1) pos.y += amp * sin(angle);	// BobY
+	else if (motion == 2) a = angle;				// RotateX
+	else if (motion == 3) b = angle;				// RotateY
+	else if (motion == 4) { a = angle; b = 0.7 * angle; }	// RotateXY
+
+	float sa = sin(a), ca = cos(a), sb = sin(b), cb = cos(b);
+	return mat4(
+		vec4(scale.x * cb, scale.x * sa * sb, -scale.x * ca * sb, 0.0),
+		vec4(0.0, scale.y * ca, scale.y * sa, 0.0),
+		vec4(scale.z * sb, -scale.z * sa * cb, scale.z * ca * cb, 0.0),
+		vec4(pos.xyz, 1.0));
+}
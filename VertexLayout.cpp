@@ -0,0 +1,240 @@
+#include "VertexLayout.h"
+#include <glm/gtc/packing.hpp>
+#include <cmath>
+#include <cstring>
+
+static unsigned int PositionBytes(PositionFormat f) { return f == PositionFormat::Float3 ? 12 : 8; }    // 3 shorts + pad
+static unsigned int NormalBytes(NormalFormat f) { return f == NormalFormat::Float3 ? 12 : 4; }
+static unsigned int UvBytes(UvFormat f) { return f == UvFormat::Float2 ? 8 : 4; }
+
+static unsigned int ColorBytes(ColorFormat f)
+{
+    if (f == ColorFormat::Float3) return 12;
+    if (f == ColorFormat::Unorm8) return 4;
+    return 0;
+}
+
+// Per-axis scale mapping the bounds onto [-1, 1]; flat axes keep 1 so their single value survives
+static glm::vec3 QuantizeScale(const glm::vec3& halfExtent)
+{
+    return glm::vec3(
+        halfExtent.x > 0.0f ? halfExtent.x : 1.0f,
+        halfExtent.y > 0.0f ? halfExtent.y : 1.0f,
+        halfExtent.z > 0.0f ? halfExtent.z : 1.0f);
+}
+
+// Position as PositionBytes(f) bytes at dst; invScale = 1 / QuantizeScale
+static void WritePosition(PositionFormat f, const float* v, const glm::vec3& center, const glm::vec3& invScale, uint8_t* dst)
+{
+    const glm::vec3 pos(v[0], v[1], v[2]);
+    if (f == PositionFormat::Float3)
+    {
+        std::memcpy(dst, &pos, sizeof(pos));
+        return;
+    }
+
+    const glm::vec3 q = glm::clamp((pos - center) * invScale, -1.0f, 1.0f);
+    const int16_t s[3] = {
+        (int16_t)std::lround(q.x * 32767.0f),
+        (int16_t)std::lround(q.y * 32767.0f),
+        (int16_t)std::lround(q.z * 32767.0f) };
+    std::memcpy(dst, s, sizeof(s));
+}
+
+// Unit vector -> octahedron folded onto the [-1, 1] square
+static glm::vec2 OctahedralEncode(glm::vec3 n)
+{
+    const float len = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (len == 0.0f) return glm::vec2(0.0f);
+
+    n /= len;
+    glm::vec2 e(n.x, n.y);
+    if (n.z < 0.0f)
+    {
+        e = glm::vec2(
+            (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+            (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+    }
+    return e;
+}
+
+VertexLayout VertexLayout::Full()
+{
+    return VertexLayout{};
+}
+
+VertexLayout VertexLayout::Compact()
+{
+    VertexLayout l;
+    l.position = PositionFormat::Snorm16;
+    l.normal = NormalFormat::Octahedral16;
+    l.uv = UvFormat::Half2;
+    l.color = ColorFormat::Unorm8;
+    l.dropConstantColor = true;
+    return l;
+}
+
+// Attributes keep the source order, so Full is byte for byte the source vertex
+int VertexLayout::ColorOffset() const
+{
+    return color == ColorFormat::None ? -1 : (int)PositionBytes(position);
+}
+
+unsigned int VertexLayout::UvOffset() const
+{
+    return PositionBytes(position) + ColorBytes(color);
+}
+
+unsigned int VertexLayout::NormalOffset() const
+{
+    return UvOffset() + UvBytes(uv);
+}
+
+unsigned int VertexLayout::PositionStride() const
+{
+    return PositionBytes(position);
+}
+
+unsigned int VertexLayout::Stride() const
+{
+    return NormalOffset() + NormalBytes(normal);
+}
+
+VertexLayout VertexLayout::ForMesh(const float* vertices, size_t vertexCount, glm::vec3& constantColor) const
+{
+    VertexLayout l = *this;
+    constantColor = glm::vec3(1.0f);
+    if (!dropConstantColor || color == ColorFormat::None || vertexCount == 0) return l;
+
+    const float* first = vertices + 3;
+    for (size_t i = 1; i < vertexCount; i++)
+        if (std::memcmp(vertices + i * kSourceFloats + 3, first, 3 * sizeof(float)) != 0)
+            return l;
+
+    constantColor = glm::vec3(first[0], first[1], first[2]);
+    l.color = ColorFormat::None;
+    return l;
+}
+
+std::vector<uint8_t> VertexLayout::Pack(const float* vertices, size_t vertexCount,
+    const glm::vec3& boundsCenter, const glm::vec3& boundsHalfExtent) const
+{
+    const unsigned int stride = Stride();
+    const unsigned int normalOffset = NormalOffset();
+    const unsigned int uvOffset = UvOffset();
+    const int colorOffset = ColorOffset();
+    const glm::vec3 invScale = 1.0f / QuantizeScale(boundsHalfExtent);
+
+    std::vector<uint8_t> out(vertexCount * stride, 0);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const float* v = vertices + i * kSourceFloats;
+        uint8_t* dst = out.data() + i * stride;
+
+        WritePosition(position, v, boundsCenter, invScale, dst);
+
+        const glm::vec3 n(v[8], v[9], v[10]);
+        if (normal == NormalFormat::Float3)
+            std::memcpy(dst + normalOffset, &n, sizeof(n));
+        else if (normal == NormalFormat::Snorm10)
+        {
+            const glm::vec3 u = glm::length(n) > 0.0f ? glm::normalize(n) : n;
+            const uint32_t p = glm::packSnorm3x10_1x2(glm::vec4(u, 0.0f));
+            std::memcpy(dst + normalOffset, &p, sizeof(p));
+        }
+        else
+        {
+            const uint32_t p = glm::packSnorm2x16(OctahedralEncode(n));
+            std::memcpy(dst + normalOffset, &p, sizeof(p));
+        }
+
+        const glm::vec2 uvs(v[6], v[7]);
+        if (uv == UvFormat::Float2)
+            std::memcpy(dst + uvOffset, &uvs, sizeof(uvs));
+        else
+        {
+            const uint32_t p = glm::packHalf2x16(uvs);
+            std::memcpy(dst + uvOffset, &p, sizeof(p));
+        }
+
+        const glm::vec3 c(v[3], v[4], v[5]);
+        if (color == ColorFormat::Float3)
+            std::memcpy(dst + colorOffset, &c, sizeof(c));
+        else if (color == ColorFormat::Unorm8)
+        {
+            const uint32_t p = glm::packUnorm4x8(glm::vec4(c, 1.0f));
+            std::memcpy(dst + colorOffset, &p, sizeof(p));
+        }
+    }
+    return out;
+}
+
+std::vector<uint8_t> VertexLayout::PackPositions(const float* vertices, size_t vertexCount,
+    const glm::vec3& boundsCenter, const glm::vec3& boundsHalfExtent) const
+{
+    const unsigned int stride = PositionStride();
+    const glm::vec3 invScale = 1.0f / QuantizeScale(boundsHalfExtent);
+
+    std::vector<uint8_t> out(vertexCount * stride, 0);
+    for (size_t i = 0; i < vertexCount; i++)
+        WritePosition(position, vertices + i * kSourceFloats, boundsCenter, invScale, out.data() + i * stride);
+    return out;
+}
+
+VertexDecode VertexLayout::Decode(const glm::vec3& boundsCenter, const glm::vec3& boundsHalfExtent) const
+{
+    VertexDecode d;
+    if (position == PositionFormat::Snorm16)
+    {
+        d.scale = glm::vec4(QuantizeScale(boundsHalfExtent), 0.0f);
+        d.offset = glm::vec4(boundsCenter, 0.0f);
+    }
+    d.scale.w = normal == NormalFormat::Octahedral16 ? 1.0f : 0.0f;
+    return d;
+}
+
+void VertexLayout::LinkAttributes() const
+{
+    const GLsizei stride = (GLsizei)Stride();
+
+    if (position == PositionFormat::Float3)
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    else
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, stride, (void*)0);
+
+    const void* normalPtr = (void*)(size_t)NormalOffset();
+    if (normal == NormalFormat::Float3)
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, normalPtr);
+    else if (normal == NormalFormat::Snorm10)
+        glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, normalPtr);
+    else
+        glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, stride, normalPtr);
+
+    const void* uvPtr = (void*)(size_t)UvOffset();
+    if (uv == UvFormat::Float2)
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, uvPtr);
+    else
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, uvPtr);
+
+    // Without a stream the color is the generic attribute value, set per mesh by the draw code
+    if (color == ColorFormat::Float3)
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)ColorOffset());
+    else if (color == ColorFormat::Unorm8)
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(size_t)ColorOffset());
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(2);
+    glEnableVertexAttribArray(3);
+    if (color == ColorFormat::None) glDisableVertexAttribArray(1);
+    else glEnableVertexAttribArray(1);
+}
+
+void VertexLayout::LinkPositionAttributes() const
+{
+    const GLsizei stride = (GLsizei)PositionStride();
+    if (position == PositionFormat::Float3)
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    else
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, stride, (void*)0);
+    glEnableVertexAttribArray(0);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+// GPU vertex format of a mesh. Loaders and primitives produce the 11-float source vertex
+// (pos3, color3, uv2, normal3); Pack converts it, LinkAttributes points attributes 0..3 at it.
+// Positions in Snorm16 are relative to the mesh bounds and normals in Octahedral16 need a decode
+// step, both described by a VertexDecode for the vertex shader's vertexDecode uniform.
+// With positionStream the positions are also kept alone, tightly packed, for shaders reading only aPos.
+enum class PositionFormat : uint8_t { Float3, Snorm16 };
+enum class NormalFormat : uint8_t { Float3, Snorm10, Octahedral16 };   // Snorm10 = 10_10_10_2
+enum class UvFormat : uint8_t { Float2, Half2 };
+enum class ColorFormat : uint8_t { Float3, Unorm8, None };
+
+// `uniform vec4 vertexDecode[2]`: position = aPos * scale.xyz + offset.xyz; scale.w = 1 for octahedral normals
+struct VertexDecode
+{
+    glm::vec4 scale{ 1.0f, 1.0f, 1.0f, 0.0f };
+    glm::vec4 offset{ 0.0f };
+
+    bool operator==(const VertexDecode& o) const { return scale == o.scale && offset == o.offset; }
+};
+
+struct VertexLayout
+{
+    static constexpr size_t kSourceFloats = 11;
+
+    PositionFormat position = PositionFormat::Float3;
+    NormalFormat normal = NormalFormat::Float3;
+    UvFormat uv = UvFormat::Float2;
+    ColorFormat color = ColorFormat::Float3;
+    bool dropConstantColor = false;     // meshes whose vertices share one color get ColorFormat::None
+    bool positionStream = false;        // second copy of the positions, PositionStride() bytes each
+
+    static VertexLayout Full();         // 44 bytes, the source vertex as is
+    static VertexLayout Compact();      // 16 bytes: snorm16 positions, octahedral normals, half UVs, no color
+
+    // Byte offsets of each attribute; color is -1 without a color stream
+    unsigned int Stride() const;
+    unsigned int PositionOffset() const { return 0; }
+    int ColorOffset() const;
+    unsigned int UvOffset() const;
+    unsigned int NormalOffset() const;
+    unsigned int PositionStride() const;    // of the position stream, same encoding as in the vertex
+
+    // The layout one mesh is stored in: color dropped if allowed and constant (returned in constantColor)
+    VertexLayout ForMesh(const float* vertices, size_t vertexCount, glm::vec3& constantColor) const;
+
+    // Source vertices -> Stride() bytes each; boundsCenter/halfExtent quantize Snorm16 positions
+    std::vector<uint8_t> Pack(const float* vertices, size_t vertexCount,
+        const glm::vec3& boundsCenter, const glm::vec3& boundsHalfExtent) const;
+
+    // Source vertices -> PositionStride() bytes each, for the position stream
+    std::vector<uint8_t> PackPositions(const float* vertices, size_t vertexCount,
+        const glm::vec3& boundsCenter, const glm::vec3& boundsHalfExtent) const;
+
+    VertexDecode Decode(const glm::vec3& boundsCenter, const glm::vec3& boundsHalfExtent) const;
+
+    // With the VAO and the vertex buffer (position stream for LinkPositionAttributes) bound
+    void LinkAttributes() const;
+    void LinkPositionAttributes() const;
+
+    // Same buffers on the GPU (dropConstantColor only matters before ForMesh)
+    bool SameFormat(const VertexLayout& o) const
+    {
+        return position == o.position && normal == o.normal && uv == o.uv && color == o.color
+            && positionStream == o.positionStream;
+    }
+};
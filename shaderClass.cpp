@@ -17,11 +17,36 @@ std::string get_file_contents(const char* filename)
 	throw(errno);
 }
 
+// Inlocuieste fiecare linie #include "fisier" cu continutul fisierului (fara recursie),
+// astfel shaderele vertex impart VertexCommon.glsl in loc sa copieze codul comun
+static std::string ExpandIncludes(const std::string& source)
+{
+	std::string out;
+	size_t begin = 0;
+	while (begin < source.size())
+	{
+		size_t end = source.find('\n', begin);
+		if (end == std::string::npos) end = source.size();
+		const std::string line = source.substr(begin, end - begin);
+
+		const size_t open = line.find('"');
+		const size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+		if (line.rfind("#include", 0) == 0 && close != std::string::npos)
+			out += get_file_contents(line.substr(open + 1, close - open - 1).c_str());
+		else
+			out += line;
+
+		out += '\n';
+		begin = end + 1;
+	}
+	return out;
+}
+
 // Construieste programul shader din fisierele vertex si fragment
 Shader::Shader(const char* vertexFile, const char* fragmentFile)
 {
-	std::string vertexCode = get_file_contents(vertexFile);
-	std::string fragmentCode = get_file_contents(fragmentFile);
+	std::string vertexCode = ExpandIncludes(get_file_contents(vertexFile));
+	std::string fragmentCode = ExpandIncludes(get_file_contents(fragmentFile));
 
 	const char* vertexSource = vertexCode.c_str();
 	const char* fragmentSource = fragmentCode.c_str();